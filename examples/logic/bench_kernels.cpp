@@ -0,0 +1,101 @@
+// Copyright 2020 Lawrence Livermore National Security, LLC and other CLIPPy
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+// Compares the generic jsonlogic evaluator with the compiled comparison
+// kernels of clippy/rule-kernel.hpp on rules of the form
+// {op: [{"var": "value"}, constant]}.
+//
+// usage: bench_kernels [evaluations-per-rule]
+
+#include <boost/json/src.hpp>
+#include <chrono>
+#include <clippy/rule-kernel.hpp>
+#include <cstdint>
+#include <iostream>
+#include <jsonlogic/src.hpp>
+#include <string>
+#include <vector>
+
+namespace bjsn = boost::json;
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+double ns_per_eval(bench_clock::time_point start, bench_clock::time_point stop,
+                   size_t n) {
+  return std::chrono::duration<double, std::nano>(stop - start).count() / n;
+}
+
+// runs rule over values with both evaluators; returns false if they disagree.
+bool bench(const std::string& op, const bjsn::value& constant,
+           const std::vector<bjsn::value>& values, size_t n) {
+  bjsn::value rule = {{op, bjsn::array{{{"var", "value"}}, constant}}};
+  auto pred = clippy::parse_var_cmp(rule);
+  if (!pred) {
+    std::cerr << "not a kernel rule: " << rule << std::endl;
+    return false;
+  }
+  clippy::json_cmp_kernel kernel(*pred);
+  jsonlogic::logic_rule jlrule = jsonlogic::create_logic(rule);
+
+  size_t generic_true = 0;
+  auto start = bench_clock::now();
+  for (size_t i = 0; i < n; ++i) {
+    const auto& v = values[i % values.size()];
+    auto res = jlrule.apply(jsonlogic::json_accessor({{"value", v}}));
+    generic_true += jsonlogic::truthy(res);
+  }
+  auto mid = bench_clock::now();
+  size_t kernel_true = 0;
+  for (size_t i = 0; i < n; ++i) {
+    auto res = kernel(values[i % values.size()]);
+    if (!res) {
+      std::cerr << "no kernel for " << rule << std::endl;
+      return false;
+    }
+    kernel_true += *res;
+  }
+  auto stop = bench_clock::now();
+
+  double generic_ns = ns_per_eval(start, mid, n);
+  double kernel_ns = ns_per_eval(mid, stop, n);
+  std::cout << rule << "  generic " << generic_ns << " ns  kernel "
+            << kernel_ns << " ns  speedup " << generic_ns / kernel_ns
+            << std::endl;
+
+  if (generic_true != kernel_true) {
+    std::cerr << "result mismatch: " << generic_true << " vs " << kernel_true
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t n = argc > 1 ? std::stoul(argv[1]) : 1000000;
+
+  std::vector<bjsn::value> ints, doubles, bools, strings;
+  for (int64_t i = 0; i < 1024; ++i) {
+    ints.emplace_back(i);
+    doubles.emplace_back(i * 0.5);
+    bools.emplace_back(i % 3 == 0);
+    strings.emplace_back("key" + std::to_string(i));
+  }
+
+  bool ok = true;
+  for (const std::string op : {"==", "!=", "<", "<=", ">", ">="}) {
+    ok = bench(op, bjsn::value(int64_t(512)), ints, n) && ok;
+    ok = bench(op, bjsn::value(256.25), doubles, n) && ok;
+    ok = bench(op, bjsn::value("key5"), strings, n) && ok;
+  }
+  for (const std::string op : {"==", "!="}) {
+    ok = bench(op, bjsn::value(true), bools, n) && ok;
+  }
+
+  return ok ? 0 : 1;
+}
@@ -2,12 +2,28 @@
 
 #include <boost/json/src.hpp>
 #include <boost/lexical_cast.hpp>
+#include <chrono>
+#include <clippy/rule-kernel.hpp>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <jsonlogic/src.hpp>
+#include <new>
 
 namespace bjsn = boost::json;
 
+// counts heap allocations, for the benchmark mode.
+static std::size_t numAllocs = 0;
+
+void* operator new(std::size_t sz) {
+  ++numAllocs;
+  if (void* p = std::malloc(sz == 0 ? 1 : sz)) return p;
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
 bjsn::value parseStream(std::istream& inps) {
   bjsn::stream_parser p;
   std::string line;
@@ -87,11 +103,164 @@ bool endsWith(const std::string& str, const std::string& suffix) {
           std::equal(suffix.rbegin(), suffix.rend(), str.rbegin()));
 }
 
+// returns a variant of the test data for record i: numbers are shifted and
+// booleans flipped, strings and the structure are kept.
+bjsn::value generateRecord(const bjsn::value& val, std::size_t i) {
+  const std::int64_t delta = std::int64_t(i % 97) - 48;
+
+  switch (val.kind()) {
+    case bjsn::kind::int64:
+      return bjsn::value(val.get_int64() + delta);
+    case bjsn::kind::uint64:
+      return bjsn::value(std::int64_t(val.get_uint64()) + delta);
+    case bjsn::kind::double_:
+      return bjsn::value(val.get_double() + delta * 0.5);
+    case bjsn::kind::bool_:
+      return bjsn::value((i % 2 == 1) != val.get_bool());
+    case bjsn::kind::array: {
+      bjsn::array res;
+      for (const bjsn::value& elem : val.get_array())
+        res.push_back(generateRecord(elem, i));
+      return res;
+    }
+    case bjsn::kind::object: {
+      bjsn::object res;
+      for (const auto& fld : val.get_object())
+        res[fld.key()] = generateRecord(fld.value(), i);
+      return res;
+    }
+    default:
+      return val;
+  }
+}
+
+using BenchClock = std::chrono::steady_clock;
+
+double seconds(BenchClock::time_point start, BenchClock::time_point stop) {
+  return std::chrono::duration<double>(stop - start).count();
+}
+
+// Compiles rule once and evaluates it numEvals times over generated records,
+// with the generic json_accessor evaluation and, if the rule has one, the
+// compiled comparison kernel. Returns non-zero if the two disagree.
+int benchmark(const bjsn::value& rule, const bjsn::value& dat,
+              std::size_t numEvals) {
+  constexpr std::size_t numRecords = 4096;
+  constexpr std::size_t numCompiles = 1000;
+
+  std::vector<bjsn::value> records;
+  records.reserve(numRecords);
+  for (std::size_t i = 0; i < numRecords; ++i)
+    records.push_back(generateRecord(dat, i));
+
+  std::cout << rule << std::endl;
+
+  auto compileStart = BenchClock::now();
+  for (std::size_t i = 1; i < numCompiles; ++i)
+    jsonlogic::logic_rule discarded = jsonlogic::create_logic(rule);
+  jsonlogic::logic_rule jlrule = jsonlogic::create_logic(rule);
+  double compileTime = seconds(compileStart, BenchClock::now()) / numCompiles;
+
+  std::cout << "  compile: " << compileTime * 1e6 << " us" << std::endl;
+
+  auto evalGeneric = [&jlrule](const bjsn::value& rec) -> bool {
+    return jsonlogic::truthy(jlrule.apply(jsonlogic::json_accessor(rec)));
+  };
+
+  try {
+    evalGeneric(records.front());
+  } catch (const std::exception& ex) {
+    std::cout << "  skipped, evaluation fails: " << ex.what() << std::endl;
+    return 0;
+  }
+
+  std::size_t numTrue = 0;
+  std::size_t allocStart = numAllocs;
+  auto genericStart = BenchClock::now();
+  for (std::size_t i = 0; i < numEvals; ++i)
+    numTrue += evalGeneric(records[i % numRecords]);
+  double genericTime = seconds(genericStart, BenchClock::now());
+
+  std::cout << "  json_accessor: " << numEvals / genericTime << " evals/s, "
+            << double(numAllocs - allocStart) / numEvals << " allocs/eval"
+            << std::endl;
+
+  std::optional<clippy::var_cmp_rule> pred = clippy::parse_var_cmp(rule);
+
+  if (!pred) return 0;
+
+  clippy::json_cmp_kernel kernel(*pred);
+  auto evalKernel = [&](const bjsn::value& rec) -> bool {
+    if (const bjsn::value* var = clippy::lookup_var(rec, pred->var))
+      if (std::optional<bool> res = kernel(*var)) return *res;
+
+    return evalGeneric(rec);
+  };
+
+  for (const bjsn::value& rec : records) {
+    if (evalKernel(rec) != evalGeneric(rec)) {
+      std::cerr << "kernel result differs for " << rec << std::endl;
+      return 1;
+    }
+  }
+
+  std::size_t numKernelTrue = 0;
+  allocStart = numAllocs;
+  auto kernelStart = BenchClock::now();
+  for (std::size_t i = 0; i < numEvals; ++i)
+    numKernelTrue += evalKernel(records[i % numRecords]);
+  double kernelTime = seconds(kernelStart, BenchClock::now());
+
+  std::cout << "  kernel: " << numEvals / kernelTime << " evals/s, "
+            << double(numAllocs - allocStart) / numEvals << " allocs/eval, "
+            << genericTime / kernelTime << "x" << std::endl;
+
+  return numTrue != numKernelTrue;
+}
+
+// Evaluates rule against dat and returns the result as JSON text.
+std::string evaluate(const bjsn::value& rule, const bjsn::value& dat) {
+  std::stringstream resStream;
+
+  resStream << jsonlogic::apply(rule, dat);
+  return resStream.str();
+}
+
+// Returns false if rule compares one variable against a constant and the
+// compiled kernel answers it for dat differently from res, the result of
+// evaluate. Values the kernel can't compare (e.g., null or mixed types) are
+// left to the generic evaluator and not checked.
+bool kernelAgrees(const bjsn::value& rule, const bjsn::value& dat,
+                  const std::string& res) {
+  std::optional<clippy::var_cmp_rule> pred = clippy::parse_var_cmp(rule);
+
+  if (!pred) return true;
+
+  const bjsn::value* var = clippy::lookup_var(dat, pred->var);
+
+  if (!var) return true;
+
+  std::optional<bool> kernelRes = clippy::json_cmp_kernel(*pred)(*var);
+
+  if (!kernelRes) return true;
+
+  std::stringstream kernelStream;
+
+  kernelStream << bjsn::value(*kernelRes);
+
+  if (kernelStream.str() == res) return true;
+
+  std::cerr << "kernel result differs: " << kernelStream.str()
+            << " instead of " << res << std::endl;
+  return false;
+}
+
 int main(int argc, const char** argv) {
   constexpr bool MATCH = false;
 
   bool verbose = false;
   bool genExpected = false;
+  std::size_t benchEvals = 0;
 
   int errorCode = 0;
   std::vector<std::string> arguments(argv, argv + argc);
@@ -114,6 +283,14 @@ int main(int argc, const char** argv) {
         matchOpt0(arguments, argn, "--verbose", setVerbose) ||
         matchOpt0(arguments, argn, "-r", setResult) ||
         matchOpt0(arguments, argn, "--result", setResult) ||
+        matchOpt1(arguments, argn, "-b",
+                  [&benchEvals](const std::string& n) -> void {
+                    benchEvals = boost::lexical_cast<std::size_t>(n);
+                  }) ||
+        matchOpt1(arguments, argn, "--bench",
+                  [&benchEvals](const std::string& n) -> void {
+                    benchEvals = boost::lexical_cast<std::size_t>(n);
+                  }) ||
         noSwitch0(arguments, argn, setFile);
   }
 
@@ -130,37 +307,37 @@ int main(int argc, const char** argv) {
   else
     dat.emplace_object();
 
+  if (benchEvals > 0) return benchmark(rule, dat, benchEvals);
+
   try {
-    jsonlogic::any_expr res = jsonlogic::apply(rule, dat);
+    std::string res = evaluate(rule, dat);
 
     if (verbose) std::cerr << res << std::endl;
 
     if (genExpected) {
-      std::stringstream resStream;
-
-      resStream << res;
+      std::stringstream resStream{res};
 
       allobj["expected"] = parseStream(resStream);
 
       if (verbose) std::cerr << allobj["expected"] << std::endl;
     } else if (hasExpected) {
       std::stringstream expStream;
-      std::stringstream resStream;
 
       expStream << allobj["expected"];
-      resStream << res;
-      errorCode = expStream.str() != resStream.str();
+      errorCode = expStream.str() != res;
 
       if (verbose && errorCode)
         std::cerr << "test failed: "
                   << "\n  exp: " << expStream.str()
-                  << "\n  got: " << resStream.str() << std::endl;
+                  << "\n  got: " << res << std::endl;
     } else {
       errorCode = 1;
 
       if (verbose)
         std::cerr << "unexpected completion, result: " << res << std::endl;
     }
+
+    if (!kernelAgrees(rule, dat, res)) errorCode = 1;
   } catch (const std::exception& ex) {
     if (verbose) std::cerr << "caught error: " << ex.what() << std::endl;
 
@@ -0,0 +1,15 @@
+#!/usr/bin/env bash
+
+evals=${1:-1000000}
+
+for tst in *.json; do
+  echo "benchmarking ../../../build/examples/logic/testeval --bench $evals <$tst"
+  ../../../build/examples/logic/testeval --bench $evals <$tst
+  res=$?
+  if [[ $res -ne 0 ]] ; then
+    echo "$res"
+    exit 1
+  fi
+done
+
+echo "qed."
@@ -0,0 +1,61 @@
+#include <iostream>
+#include <fstream>
+#include <functional>
+#include <numeric>
+
+#include "clippy/clippy.hpp"
+#include "df-common.hpp"
+
+namespace xpr = experimental;
+
+const std::string METHOD_NAME = "memory_usage";
+
+int main(int argc, char** argv)
+{
+  int            error_code = 0;
+  clippy::clippy clip{METHOD_NAME, "Returns the memory each column uses, in bytes"};
+
+  clip.member_of("Dataframe", "A dataframe");
+
+  clip.add_required_state<std::string>(ST_METALL_LOCATION, "Metall storage location");
+  clip.add_required_state<std::string>(ST_DATAFRAME_NAME,  "Name of the dataframe object");
+
+  if (clip.parse(argc, argv)) { return 0; }
+
+  try
+  {
+    std::string                     location = clip.get_state<std::string>(ST_METALL_LOCATION);
+    std::string                     key = clip.get_state<std::string>(ST_DATAFRAME_NAME);
+    std::unique_ptr<xpr::DataFrame> dfp = makeDataFrame(false, location, key);
+    xpr::DataFrame&                 df  = *dfp;
+
+    std::vector<xpr::ColumnMemory>  colMems  = df.memory_usage();
+    std::vector<std::string>        colNames = df.get_column_names();
+
+    assert(colMems.size() == colNames.size());
+
+    clippy::array                   res;
+
+    for (size_t i = 0; i < colNames.size(); ++i)
+    {
+      clippy::object elem;
+
+      elem.set_val("name",          colNames.at(i));
+      elem.set_val("sparse",        (colMems.at(i).is_sparse_column ? "true" : "false"));
+      elem.set_val("storage_bytes", colMems.at(i).storage_bytes);
+      elem.set_val("string_bytes",  colMems.at(i).string_bytes);
+      elem.set_val("total_bytes",   colMems.at(i).total_bytes());
+
+      res.append_json(std::move(elem));
+    }
+
+    clip.to_return(res);
+  }
+  catch (const std::exception& err)
+  {
+    clip.to_return(err.what());
+    error_code = 1;
+  }
+
+  return error_code;
+}
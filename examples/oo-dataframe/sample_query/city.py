@@ -12,6 +12,7 @@ df.importFile('/PATH/TO/clippy-cpp/examples/oo-dataframe/sample_data/city.csv')
 # df = Dataframe('.', "cities")
 
 df.metadata()
+df.memory_usage()
 
 df.extreme('max', 'days')
 df.extreme('min', 'days')
@@ -0,0 +1,266 @@
+// Copyright 2020 Lawrence Livermore National Security, LLC and other CLIPPy
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "boost/json.hpp"
+
+// Most filters are a single comparison of a variable against a constant,
+// e.g. {">": [{"var": "node.degree"}, 2]}. For these, a kernel compiled from
+// the rule compares a typed value against the constant directly, instead of
+// building a JSON data object and evaluating the generic jsonlogic
+// expression for every value.
+//
+// Kernels only exist for operands of the same category (both numbers, both
+// strings, or both booleans), where jsonlogic's loose comparison reduces to
+// the C++ one. Everything else, including missing (null) values, must be
+// left to the generic evaluator.
+namespace clippy {
+
+enum class cmp_kind { eq, ne, lt, le, gt, ge };
+
+using rule_constant = std::variant<bool, int64_t, double, std::string>;
+
+// A var_cmp_rule is a rule of the form {op: [{"var": name}, constant]}, with
+// the operands possibly swapped; op is stored as if the variable were on the
+// left.
+struct var_cmp_rule {
+  std::string var;
+  cmp_kind op;
+  rule_constant constant;
+};
+
+// returns the var_cmp_rule a jsonlogic rule is equivalent to, if any.
+inline std::optional<var_cmp_rule> parse_var_cmp(
+    const boost::json::value &rule) {
+  static const std::map<std::string, cmp_kind> ops{
+      {"==", cmp_kind::eq}, {"===", cmp_kind::eq}, {"!=", cmp_kind::ne},
+      {"!==", cmp_kind::ne}, {"<", cmp_kind::lt},   {"<=", cmp_kind::le},
+      {">", cmp_kind::gt},  {">=", cmp_kind::ge}};
+
+  const auto *obj = rule.if_object();
+  if (obj == nullptr || obj->size() != 1) {
+    return std::nullopt;
+  }
+  auto op_it = ops.find(std::string(obj->begin()->key()));
+  const auto *args = obj->begin()->value().if_array();
+  if (op_it == ops.end() || args == nullptr || args->size() != 2) {
+    return std::nullopt;
+  }
+
+  auto var_name =
+      [](const boost::json::value &v) -> std::optional<std::string> {
+    const auto *o = v.if_object();
+    if (o == nullptr || o->size() != 1 || !o->contains("var") ||
+        !o->at("var").is_string()) {
+      return std::nullopt;
+    }
+    return std::string(o->at("var").as_string().c_str());
+  };
+
+  auto op = op_it->second;
+  auto var = var_name((*args)[0]);
+  const auto *constant = &(*args)[1];
+  if (!var) {
+    // constant on the left: flip the comparison.
+    var = var_name((*args)[1]);
+    constant = &(*args)[0];
+    switch (op) {
+      case cmp_kind::lt:
+        op = cmp_kind::gt;
+        break;
+      case cmp_kind::le:
+        op = cmp_kind::ge;
+        break;
+      case cmp_kind::gt:
+        op = cmp_kind::lt;
+        break;
+      case cmp_kind::ge:
+        op = cmp_kind::le;
+        break;
+      default:
+        break;
+    }
+  }
+  if (!var) {
+    return std::nullopt;
+  }
+
+  if (const auto *b = constant->if_bool()) {
+    return var_cmp_rule{*var, op, *b};
+  }
+  if (const auto *i = constant->if_int64()) {
+    return var_cmp_rule{*var, op, *i};
+  }
+  if (const auto *d = constant->if_double()) {
+    return var_cmp_rule{*var, op, *d};
+  }
+  if (const auto *str = constant->if_string()) {
+    return var_cmp_rule{*var, op, std::string(str->c_str())};
+  }
+  return std::nullopt;
+}
+
+namespace detail {
+template <typename T>
+inline constexpr bool is_number_v =
+    std::is_arithmetic_v<T> && !std::is_same_v<T, bool>;
+
+template <typename T>
+inline constexpr bool is_string_v =
+    std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>;
+
+// true if jsonlogic compares a V and a C with op exactly like C++ does.
+template <typename V, typename C>
+constexpr bool has_kernel(cmp_kind op) {
+  if constexpr (is_number_v<V> && is_number_v<C>) {
+    return true;
+  } else if constexpr (is_string_v<V> && std::is_same_v<C, std::string>) {
+    return true;
+  } else if constexpr (std::is_same_v<V, bool> && std::is_same_v<C, bool>) {
+    return op == cmp_kind::eq || op == cmp_kind::ne;
+  } else {
+    return false;
+  }
+}
+
+template <cmp_kind Op, typename V, typename C>
+bool compare(const V &v, const C &c) {
+  if constexpr (Op == cmp_kind::eq) {
+    return v == c;
+  } else if constexpr (Op == cmp_kind::ne) {
+    return v != c;
+  } else if constexpr (Op == cmp_kind::lt) {
+    return v < c;
+  } else if constexpr (Op == cmp_kind::le) {
+    return v <= c;
+  } else if constexpr (Op == cmp_kind::gt) {
+    return v > c;
+  } else {
+    return v >= c;
+  }
+}
+}  // namespace detail
+
+// A var_cmp_kernel evaluates a var_cmp_rule against values of type V. Each
+// (op, constant type) pair is a separate instantiation, chosen once when the
+// kernel is compiled.
+template <typename V>
+class var_cmp_kernel {
+  using kernel_fn = bool (*)(const V &, const rule_constant &);
+
+  kernel_fn fn;
+  rule_constant constant;
+
+  var_cmp_kernel(kernel_fn fn, rule_constant constant)
+      : fn(fn), constant(std::move(constant)) {}
+
+  template <cmp_kind Op, typename C>
+  static bool apply(const V &v, const rule_constant &c) {
+    return detail::compare<Op>(v, *std::get_if<C>(&c));
+  }
+
+  template <cmp_kind Op>
+  static std::optional<var_cmp_kernel> compile_op(const rule_constant &c) {
+    return std::visit(
+        [&c](const auto &cval) -> std::optional<var_cmp_kernel> {
+          using C = std::decay_t<decltype(cval)>;
+          if constexpr (detail::has_kernel<V, C>(Op)) {
+            return var_cmp_kernel(&apply<Op, C>, c);
+          } else {
+            return std::nullopt;
+          }
+        },
+        c);
+  }
+
+ public:
+  // returns nullopt if there is no kernel for V, the rule's operator and the
+  // type of its constant.
+  static std::optional<var_cmp_kernel> compile(const var_cmp_rule &rule) {
+    switch (rule.op) {
+      case cmp_kind::eq:
+        return compile_op<cmp_kind::eq>(rule.constant);
+      case cmp_kind::ne:
+        return compile_op<cmp_kind::ne>(rule.constant);
+      case cmp_kind::lt:
+        return compile_op<cmp_kind::lt>(rule.constant);
+      case cmp_kind::le:
+        return compile_op<cmp_kind::le>(rule.constant);
+      case cmp_kind::gt:
+        return compile_op<cmp_kind::gt>(rule.constant);
+      case cmp_kind::ge:
+        return compile_op<cmp_kind::ge>(rule.constant);
+    }
+    return std::nullopt;
+  }
+
+  bool operator()(const V &v) const { return fn(v, constant); }
+};
+
+// A json_cmp_kernel evaluates a var_cmp_rule against JSON values, whose type
+// is only known at runtime.
+class json_cmp_kernel {
+  std::optional<var_cmp_kernel<bool>> bool_k;
+  std::optional<var_cmp_kernel<int64_t>> int_k;
+  std::optional<var_cmp_kernel<double>> double_k;
+  std::optional<var_cmp_kernel<std::string_view>> string_k;
+
+ public:
+  explicit json_cmp_kernel(const var_cmp_rule &rule)
+      : bool_k(var_cmp_kernel<bool>::compile(rule)),
+        int_k(var_cmp_kernel<int64_t>::compile(rule)),
+        double_k(var_cmp_kernel<double>::compile(rule)),
+        string_k(var_cmp_kernel<std::string_view>::compile(rule)) {}
+
+  // returns nullopt if v is of a kind the kernel can't compare.
+  std::optional<bool> operator()(const boost::json::value &v) const {
+    if (const auto *b = v.if_bool(); b != nullptr && bool_k) {
+      return (*bool_k)(*b);
+    }
+    if (const auto *i = v.if_int64(); i != nullptr && int_k) {
+      return (*int_k)(*i);
+    }
+    if (const auto *d = v.if_double(); d != nullptr && double_k) {
+      return (*double_k)(*d);
+    }
+    if (const auto *str = v.if_string(); str != nullptr && string_k) {
+      return (*string_k)(std::string_view(str->data(), str->size()));
+    }
+    return std::nullopt;
+  }
+};
+
+// returns the value of a (possibly dotted) jsonlogic variable in data, or
+// nullptr if it is missing.
+inline const boost::json::value *lookup_var(const boost::json::value &data,
+                                            const std::string &var) {
+  const boost::json::value *cur = &data;
+  size_t start = 0;
+  while (cur != nullptr) {
+    auto dot = var.find('.', start);
+    const auto *obj = cur->if_object();
+    if (obj == nullptr) {
+      return nullptr;
+    }
+    cur = obj->if_contains(var.substr(start, dot - start));
+    if (dot == std::string::npos) {
+      break;
+    }
+    start = dot + 1;
+  }
+  return cur;
+}
+
+}  // namespace clippy
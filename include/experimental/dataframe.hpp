@@ -136,6 +136,16 @@ using dense_vector_t  = dense_column<T>;
 template <class T>
 using sparse_vector_t = sparse_column<size_t, T>;
 
+/// heap memory used by a column, in bytes
+struct ColumnMemory
+{
+  bool        is_sparse_column = false;
+  std::size_t storage_bytes    = 0; ///< element storage, including unused capacity
+  std::size_t string_bytes     = 0; ///< buffers of strings too long to be stored inline
+
+  std::size_t total_bytes() const { return storage_bytes + string_bytes; }
+};
+
 namespace
 {
 
@@ -155,6 +165,26 @@ template <class T>
 constexpr
 const T* tag() { return nullptr; }
 
+/// returns the size of the buffer owned by \ref str, or 0 if
+///   the string is short enough to be stored inline.
+inline
+std::size_t heapBytes(const string_t& str)
+{
+  const char* obj = reinterpret_cast<const char*>(&str);
+  const char* dat = str.data();
+
+  return (dat < obj || dat >= obj + sizeof(str)) ? str.capacity() + 1 : 0;
+}
+
+/// returns the element of a dense (value) or sparse (key, value) entry
+/// \{
+template <class T>
+const T& entryValue(const T& el) { return el; }
+
+template <class T>
+const T& entryValue(const std::pair<const size_t, T>& el) { return el.second; }
+/// \}
+
 } // anonymous namespace
 
 template <class ElemType>
@@ -446,6 +476,9 @@ struct VectorAccessorBase : VectorAccessorBaseT<string_t>
   /// writes back any data held in volatile memory
   virtual void persist(void* /*cont*/) const = 0;
 
+  /// returns the heap memory used by the column
+  virtual ColumnMemory memory_usage(void* /*cont*/) const = 0;
+
   //
   // variant-based abstract API
 
@@ -541,6 +574,26 @@ struct VectorAccessorCommon : VectorAccessorBase
   {
     data(vec).clear();
   }
+
+  ColumnMemory
+  memory_usage(void* vec) const override
+  {
+    VectorRep&   col = data(vec);
+    ColumnMemory res;
+
+    res.is_sparse_column = is_sparse();
+
+    if constexpr (std::is_same<T, string_t>::value)
+    {
+      for (const auto& el : col)
+        res.string_bytes += heapBytes(entryValue(el));
+
+      res.string_bytes += heapBytes(col.default_value());
+    }
+
+    res.storage_bytes = col.capacity() * sizeof(typename VectorRep::value_type);
+    return res;
+  }
 };
 
 // dense vector accessor
@@ -800,6 +853,12 @@ struct VectorAccessorAny
       return vector().is_sparse();
     }
 
+    ColumnMemory
+    memory_usage(void* cont) const
+    {
+      return vector().memory_usage(cont);
+    }
+
     //
     // NVM data persistance
 
@@ -881,6 +940,12 @@ struct ColumnVariant
       return accessor->is_sparse();
     }
 
+    ColumnMemory
+    memory_usage() const
+    {
+      return accessor->memory_usage(container);
+    }
+
   private:
     const VectorAccessorAny* accessor;
     void*                    container;
@@ -1434,6 +1499,22 @@ struct DataFrame
         get_column_variant(idx).clear();
     }
 
+    /// returns the heap memory used by each column, in column order
+    /// \note persists the columns first, so that buffered elements
+    ///       are counted in their flat storage.
+    std::vector<ColumnMemory>
+    memory_usage() const
+    {
+      std::vector<ColumnMemory> res;
+
+      persist();
+
+      for (int idx = 0, lim = columns(); idx < lim; ++idx)
+        res.push_back(get_column_variant(idx).memory_usage());
+
+      return res;
+    }
+
 /*
     template <class... RowType>
     void xchg(int row, std::tuple<RowType...>&);
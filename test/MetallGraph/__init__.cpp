@@ -0,0 +1,44 @@
+// Copyright 2021 Lawrence Livermore National Security, LLC and other CLIPPy
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <boost/json.hpp>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "clippy/clippy.hpp"
+#include "metall_graph.hpp"
+
+static const std::string method_name = "__init__";
+static const std::string location_state = "metall_location";
+static const std::string key_state = "graph_key";
+
+int main(int argc, char **argv) {
+  clippy::clippy clip{method_name,
+                      "Opens a MetallGraph, creating its Metall datastore "
+                      "and the graph if they don't exist"};
+  clip.add_required<std::string>("location", "Location of the Metall store");
+  clip.add_required<std::string>("key",
+                                 "Name of the graph within the Metall store");
+
+  // no object-state requirements in constructor
+  if (clip.parse(argc, argv)) {
+    return 0;
+  }
+
+  auto location = clip.get<std::string>("location");
+  auto key = clip.get<std::string>("key");
+  try {
+    testgraph::metall_graph the_graph(location, key);
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  // the graph stays in the datastore; the state only says where it is.
+  clip.set_state(location_state, location);
+  clip.set_state(key_state, key);
+  return 0;
+}
@@ -0,0 +1,69 @@
+// Copyright 2021 Lawrence Livermore National Security, LLC and other CLIPPy
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <boost/json.hpp>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "clippy/clippy.hpp"
+#include "metall_graph.hpp"
+
+static const std::string method_name = "add_edges";
+static const std::string location_state = "metall_location";
+static const std::string key_state = "graph_key";
+
+int main(int argc, char **argv) {
+  clippy::clippy clip{method_name,
+                      "Inserts a list of (src, dst) edges, or those of an edge "
+                      "list file, into a MetallGraph"};
+  clip.add_optional<std::vector<testgraph::edge_t>>(
+      "edges", "List of [src, dst] pairs", {});
+  clip.add_optional<std::string>(
+      "path", "Local edge list file: tsv, csv (.csv) or binary pairs (.bin)",
+      "");
+  clip.add_optional<std::string>(
+      "format", "tsv, csv or binary; by default implied by the file name", "");
+  clip.add_required_state<std::string>(location_state,
+                                       "Location of the Metall store");
+  clip.add_required_state<std::string>(key_state,
+                                       "Name of the graph in the Metall store");
+  clip.returns_self();
+
+  // no object-state requirements in constructor
+  if (clip.parse(argc, argv)) {
+    return 0;
+  }
+
+  auto edges = clip.get<std::vector<testgraph::edge_t>>("edges");
+  auto path = clip.get<std::string>("path");
+  auto format_name = clip.get<std::string>("format");
+  auto location = clip.get_state<std::string>(location_state);
+  auto key = clip.get_state<std::string>(key_state);
+
+  auto format = testgraph::edge_list_format_of(path);
+  if (!format_name.empty()) {
+    auto named = testgraph::edge_list_format_named(format_name);
+    if (!named) {
+      std::cerr << "Unknown edge list format " << format_name << std::endl;
+      return 1;
+    }
+    format = *named;
+  }
+
+  try {
+    testgraph::metall_graph the_graph(metall::open_only, location, key);
+    if (!path.empty()) {
+      the_graph.add_edges(testgraph::read_edge_list(path, format));
+    }
+    the_graph.add_edges(edges);
+    clip.return_self();
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,55 @@
+// Copyright 2021 Lawrence Livermore National Security, LLC and other CLIPPy
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <boost/json.hpp>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "clippy/clippy.hpp"
+#include "metall_graph.hpp"
+
+static const std::string method_name = "connected_components";
+static const std::string location_state = "metall_location";
+static const std::string key_state = "graph_key";
+
+int main(int argc, char **argv) {
+  clippy::clippy clip{
+      method_name,
+      "Populates a node series with the component id of each node in a graph"};
+  clip.add_required<std::string>(
+      "series", "Node series into which the component id is written");
+  clip.add_required_state<std::string>(location_state,
+                                       "Location of the Metall store");
+  clip.add_required_state<std::string>(key_state,
+                                       "Name of the graph in the Metall store");
+  clip.returns<size_t>("Number of components.");
+
+  // no object-state requirements in constructor
+  if (clip.parse(argc, argv)) {
+    return 0;
+  }
+
+  auto series = clip.get<std::string>("series");
+  auto location = clip.get_state<std::string>(location_state);
+  auto key = clip.get_state<std::string>(key_state);
+  try {
+    testgraph::metall_graph the_graph(metall::open_only, location, key);
+    // components are numbered by the smallest node id in them.
+    auto labels = testgraph::connected_components(the_graph.out_edges());
+    auto cc = the_graph.node_series<int64_t>(series);
+    size_t count = 0;
+    for (testgraph::node_id i = 0; i < cc.size(); ++i) {
+      cc[i] = int64_t(labels[i]);
+      count += labels[i] == i ? 1 : 0;
+    }
+    clip.to_return(count);
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
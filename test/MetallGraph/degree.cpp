@@ -0,0 +1,51 @@
+// Copyright 2021 Lawrence Livermore National Security, LLC and other CLIPPy
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <boost/json.hpp>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "clippy/clippy.hpp"
+#include "metall_graph.hpp"
+
+static const std::string method_name = "degree";
+static const std::string location_state = "metall_location";
+static const std::string key_state = "graph_key";
+
+int main(int argc, char **argv) {
+  clippy::clippy clip{method_name,
+                      "Populates a node series with the degree of each node"};
+  clip.add_required<std::string>(
+      "series", "Node series into which the degree is written");
+  clip.add_required_state<std::string>(location_state,
+                                       "Location of the Metall store");
+  clip.add_required_state<std::string>(key_state,
+                                       "Name of the graph in the Metall store");
+  clip.returns_self();
+
+  // no object-state requirements in constructor
+  if (clip.parse(argc, argv)) {
+    return 0;
+  }
+
+  auto series = clip.get<std::string>("series");
+  auto location = clip.get_state<std::string>(location_state);
+  auto key = clip.get_state<std::string>(key_state);
+  try {
+    testgraph::metall_graph the_graph(metall::open_only, location, key);
+    // degrees are kept as edges are added, so this is one pass over nodes.
+    auto degrees = the_graph.node_series<int64_t>(series);
+    for (testgraph::node_id i = 0; i < degrees.size(); ++i) {
+      degrees[i] = int64_t(the_graph.degree(i));
+    }
+    clip.return_self();
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
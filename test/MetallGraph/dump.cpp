@@ -0,0 +1,59 @@
+// Copyright 2021 Lawrence Livermore National Security, LLC and other CLIPPy
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <boost/json.hpp>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "clippy/clippy.hpp"
+#include "metall_graph.hpp"
+
+static const std::string method_name = "dump";
+static const std::string location_state = "metall_location";
+static const std::string key_state = "graph_key";
+
+int main(int argc, char **argv) {
+  clippy::clippy clip{method_name,
+                      "Returns the values of a node series by node name"};
+  clip.add_required<std::string>("series", "Node series to dump");
+  clip.add_required_state<std::string>(location_state,
+                                       "Location of the Metall store");
+  clip.add_required_state<std::string>(key_state,
+                                       "Name of the graph in the Metall store");
+  clip.returns<boost::json::object>("Map of node name to value");
+
+  // no object-state requirements in constructor
+  if (clip.parse(argc, argv)) {
+    return 0;
+  }
+
+  auto series = clip.get<std::string>("series");
+  auto location = clip.get_state<std::string>(location_state);
+  auto key = clip.get_state<std::string>(key_state);
+  try {
+    testgraph::metall_graph the_graph(metall::open_only, location, key);
+    boost::json::object values;
+    auto dump = [&the_graph, &values](auto ser) {
+      for (testgraph::node_id i = 0; i < ser.size(); ++i) {
+        values[the_graph.node_name(i)] = ser[i];
+      }
+    };
+    if (auto ints = the_graph.find_node_series<int64_t>(series)) {
+      dump(*ints);
+    } else if (auto reals = the_graph.find_node_series<double>(series)) {
+      dump(*reals);
+    } else {
+      std::cerr << "Node series " << series << " not found" << std::endl;
+      return 1;
+    }
+    clip.to_return(values);
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,318 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <boost/container/vector.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "../TestGraph/components.hpp"
+#include "../TestGraph/edge_list.hpp"
+#include "../TestGraph/testgraph.hpp"
+#include "metall/metall.hpp"
+
+namespace testgraph {
+
+// A graph that lives in a Metall datastore rather than in the JSON state:
+// opening one maps the datastore, and every change is made in place, so the
+// cost of a small update doesn't grow with the graph. mvmap's tables can't
+// be stored this way, since their containers hold raw pointers; instead the
+// node and edge tables are laid out in Metall-allocated containers, and each
+// series is a dense column of its own, as in experimental::DataFrame.
+//
+// Node names are packed end to end with an offset per node id, and found
+// through a multimap from a stable hash of the name to ids. Edges are keyed
+// by node id pairs, as in testgraph, with a row number per edge.
+class metall_graph {
+  template <typename T>
+  using persistent_alloc = metall::manager::allocator_type<T>;
+  template <typename T>
+  using persistent_vector = boost::container::vector<T, persistent_alloc<T>>;
+
+  // hashes of persistent keys must not change between runs, so names are
+  // hashed with FNV-1a rather than std::hash.
+  static uint64_t name_hash(std::string_view name) {
+    uint64_t h = 0xcbf29ce484222325;
+    for (char c : name) {
+      h = (h ^ uint8_t(c)) * 0x100000001b3;
+    }
+    return h;
+  }
+
+  struct edge_key_hash {
+    size_t operator()(const edge_key &key) const {
+      return mvmap::mix_bits(key.first * 0x9e3779b97f4a7c15 ^ key.second);
+    }
+  };
+
+  // the part of the graph in the datastore, constructed under the graph's
+  // key.
+  struct store {
+    using name_index_t = boost::unordered_multimap<
+        uint64_t, node_id, boost::hash<uint64_t>, std::equal_to<uint64_t>,
+        persistent_alloc<std::pair<const uint64_t, node_id>>>;
+    using edge_index_t = boost::unordered_map<
+        edge_key, uint64_t, edge_key_hash, std::equal_to<edge_key>,
+        persistent_alloc<std::pair<const edge_key, uint64_t>>>;
+
+    persistent_vector<char> name_chars;
+    persistent_vector<uint64_t> name_offsets;
+    name_index_t name_index;
+    persistent_vector<edge_key> edge_keys;
+    edge_index_t edge_index;
+    // edges incident to each node, counting a self-loop once.
+    persistent_vector<uint64_t> degrees;
+
+    explicit store(const persistent_alloc<std::byte> &alloc)
+        : name_chars(alloc),
+          name_offsets(1, 0, alloc),
+          name_index(alloc),
+          edge_keys(alloc),
+          edge_index(alloc),
+          degrees(alloc) {}
+  };
+
+  std::unique_ptr<metall::manager> manager;
+  std::string key;
+  store *graph = nullptr;
+
+  [[nodiscard]] std::string series_key(const std::string &table,
+                                       const std::string &type,
+                                       const std::string &name) const {
+    return key + "~" + table + "~" + type + "~" + name;
+  }
+
+  template <typename T>
+  static std::string type_name() {
+    static_assert(std::is_same_v<T, int64_t> || std::is_same_v<T, double>,
+                  "series hold int64_t or double");
+    return std::is_same_v<T, int64_t> ? "int64" : "double";
+  }
+
+  template <typename T>
+  persistent_vector<T> *find_series(const std::string &table,
+                                    const std::string &name) {
+    return manager
+        ->find<persistent_vector<T>>(
+            series_key(table, type_name<T>(), name).c_str())
+        .first;
+  }
+
+  [[nodiscard]] bool has_series(const std::string &table,
+                                const std::string &name) {
+    return find_series<int64_t>(table, name) != nullptr ||
+           find_series<double>(table, name) != nullptr;
+  }
+
+  // the series, sized to the table, adding it if need be. Throws
+  // std::invalid_argument if the name holds a series of another type.
+  template <typename T>
+  persistent_vector<T> &table_series(const std::string &table,
+                                     const std::string &name, size_t rows) {
+    auto *ser = find_series<T>(table, name);
+    if (ser == nullptr) {
+      if (has_series(table, name)) {
+        throw std::invalid_argument(table + " series " + name +
+                                    " holds another type");
+      }
+      ser = manager->construct<persistent_vector<T>>(
+          series_key(table, type_name<T>(), name).c_str())(
+          manager->get_allocator<T>());
+    }
+    ser->resize(rows);
+    return *ser;
+  }
+
+  // opens the datastore at path. Throws std::runtime_error, rather than
+  // open it, if it wasn't closed properly.
+  static std::unique_ptr<metall::manager> open_datastore(
+      const std::string &path) {
+    if (!metall::manager::consistent(path.c_str())) {
+      throw std::runtime_error("the datastore at " + path +
+                               " is inconsistent; it may not have been "
+                               "closed properly");
+    }
+    return std::make_unique<metall::manager>(metall::open_only, path.c_str());
+  }
+
+  void open_graph(bool create) {
+    auto *found = manager->find<store>(key.c_str()).first;
+    if (found == nullptr && !create) {
+      throw std::runtime_error("no graph " + key + " in the datastore");
+    }
+    graph = found != nullptr ? found
+                             : manager->construct<store>(key.c_str())(
+                                   manager->get_allocator<std::byte>());
+  }
+
+  void count_edge(const edge_key &e) {
+    graph->degrees[e.first] += 1;
+    if (e.second != e.first) {
+      graph->degrees[e.second] += 1;
+    }
+  }
+
+ public:
+  // opens the graph stored under key in the datastore at path, creating
+  // the datastore and the graph if need be. Throws std::runtime_error,
+  // rather than overwrite it, if the datastore exists but wasn't closed
+  // properly.
+  metall_graph(const std::string &path, std::string graph_key)
+      : key(std::move(graph_key)) {
+    if (!std::filesystem::exists(path)) {
+      manager =
+          std::make_unique<metall::manager>(metall::create_only, path.c_str());
+    } else {
+      manager = open_datastore(path);
+    }
+    open_graph(true);
+  }
+
+  // opens an existing graph; throws std::runtime_error if there is none, or
+  // if the datastore wasn't closed properly.
+  metall_graph(metall::open_only_t /*unused*/, const std::string &path,
+               std::string graph_key)
+      : manager(open_datastore(path)), key(std::move(graph_key)) {
+    open_graph(false);
+  }
+
+  metall_graph(const metall_graph &) = delete;
+  metall_graph &operator=(const metall_graph &) = delete;
+
+  [[nodiscard]] size_t nv() const { return graph->name_offsets.size() - 1; }
+  [[nodiscard]] size_t ne() const { return graph->edge_keys.size(); }
+
+  [[nodiscard]] std::string_view node_name(node_id id) const {
+    auto first = graph->name_offsets[id];
+    return {graph->name_chars.data() + first,
+            size_t(graph->name_offsets[id + 1] - first)};
+  }
+
+  [[nodiscard]] std::optional<node_id> find_node(std::string_view name) const {
+    auto [first, last] = graph->name_index.equal_range(name_hash(name));
+    for (auto it = first; it != last; ++it) {
+      if (node_name(it->second) == name) {
+        return it->second;
+      }
+    }
+    return std::nullopt;
+  }
+
+  // returns the id of a node, adding the node if it isn't in the graph.
+  node_id intern(std::string_view name) {
+    if (auto id = find_node(name)) {
+      return *id;
+    }
+    node_id id = nv();
+    graph->name_chars.insert(graph->name_chars.end(), name.begin(),
+                             name.end());
+    graph->name_offsets.push_back(graph->name_chars.size());
+    graph->name_index.emplace(name_hash(name), id);
+    graph->degrees.push_back(0);
+    return id;
+  }
+
+  bool add_node(std::string_view name) {
+    auto before = nv();
+    intern(name);
+    return nv() > before;
+  }
+
+  bool add_edge(std::string_view src, std::string_view dst) {
+    edge_key e{intern(src), intern(dst)};
+    if (!graph->edge_index.emplace(e, ne()).second) {
+      return false;
+    }
+    graph->edge_keys.push_back(e);
+    count_edge(e);
+    return true;
+  }
+
+  // adds the edges of an edge list, and the nodes that aren't in the graph
+  // yet. Returns the number of edges added.
+  size_t add_edges(const edge_list &list) {
+    size_t before = ne();
+    graph->edge_index.reserve(before + list.size());
+    for (size_t i = 0; i < list.size(); ++i) {
+      add_edge(list.names[2 * i], list.names[2 * i + 1]);
+    }
+    return ne() - before;
+  }
+
+  size_t add_edges(std::span<const edge_t> edges) {
+    size_t before = ne();
+    graph->edge_index.reserve(before + edges.size());
+    for (const auto &[src, dst] : edges) {
+      add_edge(src, dst);
+    }
+    return ne() - before;
+  }
+
+  [[nodiscard]] std::optional<edge_key> find_edge(std::string_view src,
+                                                  std::string_view dst) const {
+    auto s = find_node(src);
+    auto d = find_node(dst);
+    if (!s || !d || graph->edge_index.count({*s, *d}) == 0) {
+      return std::nullopt;
+    }
+    return edge_key{*s, *d};
+  }
+
+  // the number of edges incident to a node, counting a self-loop once.
+  [[nodiscard]] size_t degree(node_id id) const { return graph->degrees[id]; }
+
+  // the edges over node ids, as the rows of a CSR.
+  [[nodiscard]] csr out_edges() const {
+    std::vector<std::pair<mvmap::index, mvmap::index>> pairs(
+        graph->edge_keys.begin(), graph->edge_keys.end());
+    return {nv(), pairs};
+  }
+
+  // node and edge series are dense columns of int64_t or double, with a
+  // value for every node or edge row; see table_series.
+  [[nodiscard]] bool has_node_series(const std::string &name) {
+    return has_series("node", name);
+  }
+  [[nodiscard]] bool has_edge_series(const std::string &name) {
+    return has_series("edge", name);
+  }
+
+  template <typename T>
+  std::span<T> node_series(const std::string &name) {
+    auto &ser = table_series<T>("node", name, nv());
+    return {ser.data(), ser.size()};
+  }
+  template <typename T>
+  std::span<T> edge_series(const std::string &name) {
+    auto &ser = table_series<T>("edge", name, ne());
+    return {ser.data(), ser.size()};
+  }
+
+  // the values of an existing node series, or nullopt if there is none.
+  template <typename T>
+  std::optional<std::span<const T>> find_node_series(const std::string &name) {
+    auto *ser = find_series<T>("node", name);
+    if (ser == nullptr) {
+      return std::nullopt;
+    }
+    ser->resize(nv());
+    return std::span<const T>(ser->data(), ser->size());
+  }
+
+  bool drop_node_series(const std::string &name) {
+    return manager->destroy<persistent_vector<int64_t>>(
+               series_key("node", "int64", name).c_str()) ||
+           manager->destroy<persistent_vector<double>>(
+               series_key("node", "double", name).c_str());
+  }
+};
+
+}  // namespace testgraph
@@ -52,6 +52,17 @@ class testdf {
     return df;
   }
 
+  // the binary format is that of the underlying mvmap.
+  void write_binary(std::ostream &os) const { data.write_binary(os); }
+  void save_binary(const std::string &path) const { data.save_binary(path); }
+
+  static testdf read_binary(std::span<const std::byte> bytes) {
+    return {df_mvmap::read_binary(bytes)};
+  }
+  static testdf load_binary(const std::string &path) {
+    return {df_mvmap::load_binary(path)};
+  }
+
   // bool is_index(const std::string &idx) {
   //   if (!index.has_value()) {
   //     return false;
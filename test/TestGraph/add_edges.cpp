@@ -0,0 +1,61 @@
+// Copyright 2021 Lawrence Livermore National Security, LLC and other CLIPPy
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <boost/json.hpp>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "clippy/clippy.hpp"
+#include "edge_list.hpp"
+#include "testgraph.hpp"
+
+static const std::string method_name = "add_edges";
+static const std::string state_name = "INTERNAL";
+
+int main(int argc, char **argv) {
+  clippy::clippy clip{method_name,
+                      "Inserts a list of (src, dst) edges, or those of an edge "
+                      "list file, into a TestGraph"};
+  clip.add_optional<std::vector<testgraph::edge_t>>(
+      "edges", "List of [src, dst] pairs", {});
+  clip.add_optional<std::string>(
+      "path", "Local edge list file: tsv, csv (.csv) or binary pairs (.bin)",
+      "");
+  clip.add_optional<std::string>(
+      "format", "tsv, csv or binary; by default implied by the file name", "");
+  clip.add_required_state<testgraph::testgraph>(state_name,
+                                                "Internal container");
+  clip.returns_self();
+
+  // no object-state requirements in constructor
+  if (clip.parse(argc, argv)) {
+    return 0;
+  }
+
+  auto edges = clip.get<std::vector<testgraph::edge_t>>("edges");
+  auto path = clip.get<std::string>("path");
+  auto format_name = clip.get<std::string>("format");
+  auto the_graph = clip.get_state<testgraph::testgraph>(state_name);
+
+  if (!path.empty()) {
+    try {
+      auto format = testgraph::resolve_edge_list_format(path, format_name);
+      auto list = testgraph::read_edge_list(path, format);
+      the_graph.add_edges(list);
+    } catch (const std::runtime_error &e) {
+      std::cerr << e.what() << std::endl;
+      return 1;
+    }
+  }
+  the_graph.add_edges(edges);
+  clip.set_state(state_name, the_graph);
+  // the graph can be large, and this process exits once it is saved, so it
+  // isn't torn down.
+  the_graph.forget();
+  clip.return_self();
+  return 0;
+}
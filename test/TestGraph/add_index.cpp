@@ -0,0 +1,56 @@
+// Copyright 2021 Lawrence Livermore National Security, LLC and other CLIPPy
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <boost/json.hpp>
+#include <iostream>
+
+#include "clippy/clippy.hpp"
+#include "clippy/selector.hpp"
+#include "testgraph.hpp"
+
+static const std::string method_name = "add_index";
+static const std::string graph_state_name = "INTERNAL";
+
+int main(int argc, char **argv) {
+  clippy::clippy clip{method_name,
+                      "Adds a sorted index to a series so that range and "
+                      "equality filters on it can avoid a scan"};
+  clip.add_required<selector>("selector", "Existing selector to index");
+  clip.add_required_state<testgraph::testgraph>(graph_state_name,
+                                                "Internal state for the graph");
+  clip.returns_self();
+
+  if (clip.parse(argc, argv)) {
+    return 0;
+  }
+
+  auto sel = clip.get<selector>("selector");
+  auto tail_opt = sel.tail();
+  if (!tail_opt) {
+    std::cerr << "Selector must have a tail" << std::endl;
+    return 1;
+  }
+  auto subsel = tail_opt.value();
+
+  auto the_graph = clip.get_state<testgraph::testgraph>(graph_state_name);
+  bool indexed = false;
+  if (sel.headeq("edge")) {
+    indexed = the_graph.add_edge_index(subsel);
+  } else if (sel.headeq("node")) {
+    indexed = the_graph.add_node_index(subsel);
+  } else {
+    std::cerr << "Selector name must start with either \"edge.\" or \"node.\""
+              << std::endl;
+    return 1;
+  }
+  if (!indexed) {
+    std::cerr << "Selector " << sel << " is not populated" << std::endl;
+    return 1;
+  }
+
+  clip.set_state(graph_state_name, the_graph);
+  clip.return_self();
+  return 0;
+}
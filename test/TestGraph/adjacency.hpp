@@ -0,0 +1,213 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "../include/mvmap.hpp"
+#include "parallel.hpp"
+
+namespace testgraph {
+
+// A compressed sparse row (CSR) matrix over node indices: the neighbors of
+// node i are targets[offsets[i], offsets[i + 1]), in ascending order. A
+// weighted matrix also holds the value of each entry, in the same order.
+class csr {
+  std::vector<uint64_t> offsets{0};
+  std::vector<mvmap::index> targets;
+  std::vector<double> weights;
+
+  void count_rows(
+      size_t num_rows,
+      const std::vector<std::pair<mvmap::index, mvmap::index>> &pairs) {
+    offsets.assign(num_rows + 1, 0);
+    for (const auto &[r, c] : pairs) {
+      ++offsets[r + 1];
+    }
+    for (size_t r = 0; r < num_rows; ++r) {
+      offsets[r + 1] += offsets[r];
+    }
+  }
+
+ public:
+  csr() = default;
+
+  // builds the matrix from (row, column) pairs of indices below num_rows.
+  csr(size_t num_rows,
+      const std::vector<std::pair<mvmap::index, mvmap::index>> &pairs)
+      : targets(pairs.size()) {
+    count_rows(num_rows, pairs);
+    auto next = offsets;
+    for (const auto &[r, c] : pairs) {
+      targets[next[r]++] = c;
+    }
+    for (size_t r = 0; r < num_rows; ++r) {
+      std::sort(targets.begin() + offsets[r], targets.begin() + offsets[r + 1]);
+    }
+  }
+
+  // as above, with values[k] the value of the entry pairs[k].
+  csr(size_t num_rows,
+      const std::vector<std::pair<mvmap::index, mvmap::index>> &pairs,
+      const std::vector<double> &values)
+      : targets(pairs.size()), weights(pairs.size()) {
+    count_rows(num_rows, pairs);
+    std::vector<std::pair<mvmap::index, double>> entries(pairs.size());
+    auto next = offsets;
+    for (size_t k = 0; k < pairs.size(); ++k) {
+      entries[next[pairs[k].first]++] = {pairs[k].second, values[k]};
+    }
+    for (size_t r = 0; r < num_rows; ++r) {
+      std::sort(entries.begin() + offsets[r], entries.begin() + offsets[r + 1],
+                [](const auto &a, const auto &b) { return a.first < b.first; });
+    }
+    for (size_t k = 0; k < entries.size(); ++k) {
+      std::tie(targets[k], weights[k]) = entries[k];
+    }
+  }
+
+  // adopts the arrays of an unweighted matrix whose rows are already sorted.
+  csr(std::vector<uint64_t> row_offsets, std::vector<mvmap::index> columns)
+      : offsets(std::move(row_offsets)), targets(std::move(columns)) {}
+
+  [[nodiscard]] size_t num_rows() const { return offsets.size() - 1; }
+  [[nodiscard]] size_t num_entries() const { return targets.size(); }
+  [[nodiscard]] bool is_weighted() const { return !weights.empty(); }
+
+  [[nodiscard]] std::span<const mvmap::index> neighbors(mvmap::index i) const {
+    if (i >= num_rows()) {
+      return {};
+    }
+    return {targets.data() + offsets[i], targets.data() + offsets[i + 1]};
+  }
+
+  // the values of the entries of row i, or an empty span if the matrix is
+  // unweighted.
+  [[nodiscard]] std::span<const double> values(mvmap::index i) const {
+    if (i >= num_rows() || !is_weighted()) {
+      return {};
+    }
+    return {weights.data() + offsets[i], weights.data() + offsets[i + 1]};
+  }
+
+  [[nodiscard]] size_t degree(mvmap::index i) const {
+    return i < num_rows() ? offsets[i + 1] - offsets[i] : 0;
+  }
+
+  [[nodiscard]] const std::vector<uint64_t> &row_offsets() const {
+    return offsets;
+  }
+  [[nodiscard]] const std::vector<mvmap::index> &columns() const {
+    return targets;
+  }
+};
+
+// the simple undirected graph underlying the directed graph with out edges
+// out and in edges in: row i holds each node other than i joined to it by an
+// edge either way, once. Rows are merged on num_threads threads.
+inline csr undirected(const csr &out, const csr &in, unsigned num_threads = 0) {
+  size_t n = out.num_rows();
+  num_threads = thread_count(out.num_entries() + n, num_threads);
+  // merges row i of out and in into dst, and returns the end of the merge.
+  auto merge_row = [&out, &in](mvmap::index i, mvmap::index *dst) {
+    auto o = out.neighbors(i);
+    auto r = in.neighbors(i);
+    auto end = std::set_union(o.begin(), o.end(), r.begin(), r.end(), dst);
+    end = std::unique(dst, end);
+    return std::remove(dst, end, i);
+  };
+
+  std::vector<uint64_t> offsets(n + 1, 0);
+  parallel_blocks(n, num_threads,
+                  [&](unsigned /*t*/, size_t lo, size_t hi) {
+                    std::vector<mvmap::index> row;
+                    for (auto i = lo; i < hi; ++i) {
+                      row.resize(out.degree(i) + in.degree(i));
+                      offsets[i + 1] = merge_row(i, row.data()) - row.data();
+                    }
+                  });
+  for (size_t i = 0; i < n; ++i) {
+    offsets[i + 1] += offsets[i];
+  }
+  std::vector<mvmap::index> targets(offsets[n]);
+  parallel_blocks(n, num_threads,
+                  [&](unsigned /*t*/, size_t lo, size_t hi) {
+                    std::vector<mvmap::index> row;
+                    for (auto i = lo; i < hi; ++i) {
+                      row.resize(out.degree(i) + in.degree(i));
+                      auto end = merge_row(i, row.data());
+                      std::copy(row.data(), end, targets.begin() + offsets[i]);
+                    }
+                  });
+  return {std::move(offsets), std::move(targets)};
+}
+
+// The adjacency of a graph over its node ids: a CSR of the out edges and one
+// of the in edges. It records the key versions of the node and edge tables
+// it was built from, so the graph can tell when it is stale.
+class adjacency {
+  csr out;
+  csr in;
+  mvmap::selection loops;
+  uint64_t node_version = 0;
+  uint64_t edge_version = 0;
+
+ public:
+  adjacency() = default;
+
+  template <typename NodeMap, typename EdgeMap>
+  adjacency(const NodeMap &nodes, const EdgeMap &edges)
+      : node_version(nodes.keys_version()),
+        edge_version(edges.keys_version()) {
+    std::vector<std::pair<mvmap::index, mvmap::index>> pairs;
+    pairs.reserve(edges.size());
+    for (const auto &[s, d] : edges.keys()) {
+      if (nodes.has_key_at(s) && nodes.has_key_at(d)) {
+        pairs.emplace_back(s, d);
+        if (s == d) {
+          loops.insert(s);
+        }
+      }
+    }
+    size_t n = nodes.index_capacity();
+    out = csr(n, pairs);
+    for (auto &[s, d] : pairs) {
+      std::swap(s, d);
+    }
+    in = csr(n, pairs);
+  }
+
+  template <typename NodeMap, typename EdgeMap>
+  [[nodiscard]] bool is_current(const NodeMap &nodes,
+                                const EdgeMap &edges) const {
+    return node_version == nodes.keys_version() &&
+           edge_version == edges.keys_version();
+  }
+
+  [[nodiscard]] const csr &out_edges() const { return out; }
+  [[nodiscard]] const csr &in_edges() const { return in; }
+
+  [[nodiscard]] std::span<const mvmap::index> out_neighbors(
+      mvmap::index i) const {
+    return out.neighbors(i);
+  }
+  [[nodiscard]] std::span<const mvmap::index> in_neighbors(
+      mvmap::index i) const {
+    return in.neighbors(i);
+  }
+
+  [[nodiscard]] size_t out_degree(mvmap::index i) const {
+    return out.degree(i);
+  }
+  [[nodiscard]] size_t in_degree(mvmap::index i) const { return in.degree(i); }
+
+  // the number of edges incident to node i, counting a self-loop once.
+  [[nodiscard]] size_t degree(mvmap::index i) const {
+    return out.degree(i) + in.degree(i) - (loops.contains(i) ? 1 : 0);
+  }
+};
+
+}  // namespace testgraph
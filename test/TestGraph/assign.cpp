@@ -113,7 +113,7 @@ int main(int argc, char **argv) {
       return 1;
     }
 
-    auto nodemap = the_graph.nodemap();
+    auto &nodemap = the_graph.nodemap();
     auto where = parse_where_expression(nodemap, where_exp, submission_data);
     if (std::holds_alternative<bool>(val)) {
       auto col_opt = the_graph.add_node_series<bool>(subsel, desc);
@@ -256,7 +256,7 @@ int main(int argc, char **argv) {
       return 1;
     }
 
-    auto edgemap = the_graph.edgemap();
+    auto &edgemap = the_graph.edgemap();
     auto where = parse_where_expression(edgemap, where_exp, submission_data);
     switch (val.kind()) {
       case boost::json::kind::bool_: {
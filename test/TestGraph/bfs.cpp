@@ -1,34 +1,152 @@
+// Copyright 2021 Lawrence Livermore National Security, LLC and other CLIPPy
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <boost/json.hpp>
+#include <chrono>
+#include <clippy/clippy.hpp>
 #include <iostream>
-#include <numeric>
-#include <vector>
-
-int main() {
-  std::vector<std::vector<long int>> adj{{1}, {0, 2}, {1}, {4}, {3}};
-  std::vector<long int> components(adj.size());
-  std::iota(components.begin(), components.end(), 0);
-
-  std::vector<long int> curr_level{0};
-  std::vector<long int> next_level{};
-  std::vector<bool> visited(adj.size(), false);
-
-  long int u{};
-
-  while (!curr_level.empty()) {
-    u = curr_level.back();
-    std::cout << "u = " << u << "\n";
-    curr_level.pop_back();
-    for (long int v : adj[u]) {
-      std::cout << "   testing " << v << "\n";
-      if (!visited[v]) {
-        std::cout << "    visiting " << v << "\n";
-        visited[v] = true;
-        components[v] = components[u];
-        std::cout << "    components[" << v << "] = " << components[u] << "\n";
-        next_level.push_back(v);
+#include <jsonlogic/src.hpp>
+#include <map>
+#include <optional>
+
+#include "bfs.hpp"
+#include "clippy/selector.hpp"
+#include "testgraph.hpp"
+
+static const std::string method_name = "bfs";
+static const std::string state_name = "INTERNAL";
+static const std::string sel_state_name = "selectors";
+
+namespace {
+
+// the tail of a node selector that names a pending, unpopulated series, or
+// nullopt after reporting why not.
+std::optional<std::string> new_node_series(
+    const testgraph::testgraph &g,
+    const std::map<std::string, std::string> &selectors, const selector &sel) {
+  if (!sel.headeq("node")) {
+    std::cerr << "Selector must be a node subselector" << std::endl;
+    return std::nullopt;
+  }
+  if (!selectors.contains(sel)) {
+    std::cerr << "Selector not found" << std::endl;
+    return std::nullopt;
+  }
+  std::string subsel = sel.tail().value();
+  if (g.has_node_series(subsel)) {
+    std::cerr << "Selector already populated" << std::endl;
+    return std::nullopt;
+  }
+  return subsel;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  clippy::clippy clip{method_name,
+                      "Populates the distance (and optionally the parent) of "
+                      "each node reached by a breadth-first search"};
+  clip.add_required<std::string>("source", "Node to start the search from");
+  clip.add_required<selector>(
+      "distance", "Existing selector name into which the distance is written");
+  clip.add_optional<boost::json::object>(
+      "parent", "Existing selector name into which the parent is written",
+      boost::json::object{});
+  clip.add_optional<int64_t>(
+      "max_depth", "If not negative, the number of levels to search", -1);
+  clip.add_required_state<testgraph::testgraph>(state_name,
+                                                "Internal container");
+  clip.add_required_state<std::map<std::string, std::string>>(
+      sel_state_name, "Internal container for pending selectors");
+  clip.returns<boost::json::object>(
+      "Nodes visited, depth reached, edges traversed, seconds and traversed "
+      "edges per second (TEPS)");
+
+  // no object-state requirements in constructor
+  if (clip.parse(argc, argv)) {
+    return 0;
+  }
+
+  auto source = clip.get<std::string>("source");
+  auto max_depth = clip.get<int64_t>("max_depth");
+  auto the_graph = clip.get_state<testgraph::testgraph>(state_name);
+  auto selectors =
+      clip.get_state<std::map<std::string, std::string>>(sel_state_name);
+
+  auto source_id = the_graph.find_node(source);
+  if (!source_id) {
+    std::cerr << "Source node not found" << std::endl;
+    return 1;
+  }
+
+  auto dist_name =
+      new_node_series(the_graph, selectors, clip.get<selector>("distance"));
+  if (!dist_name) {
+    return 1;
+  }
+  std::optional<std::string> parent_name;
+  if (clip.has_argument("parent")) {
+    parent_name = new_node_series(
+        the_graph, selectors, selector(clip.get<boost::json::object>("parent")));
+    if (!parent_name) {
+      return 1;
+    }
+    if (*parent_name == *dist_name) {
+      std::cerr << "Parent and distance selectors must differ" << std::endl;
+      return 1;
+    }
+  }
+
+  auto dist_o = the_graph.add_node_series<int64_t>(*dist_name, "BFS distance");
+  if (!dist_o) {
+    std::cerr << "Unable to manifest node series" << std::endl;
+    return 1;
+  }
+  auto dist = dist_o.value();
+
+  const auto &adj = the_graph.adjacency_index();
+  auto start = std::chrono::steady_clock::now();
+  auto result = testgraph::bfs(adj.out_edges(), adj.in_edges(), *source_id,
+                               max_depth);
+  double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                              start)
+                    .count();
+
+  // nodes the search did not reach are left out of the series.
+  for (testgraph::node_id i = 0; i < result.distance.size(); ++i) {
+    if (result.distance[i] >= 0) {
+      dist[testgraph::testgraph::node_locator(i)] = result.distance[i];
+    }
+  }
+
+  if (parent_name) {
+    auto parent_o =
+        the_graph.add_node_series<std::string>(*parent_name, "BFS parent");
+    if (!parent_o) {
+      std::cerr << "Unable to manifest node series" << std::endl;
+      return 1;
+    }
+    auto parent = parent_o.value();
+    for (testgraph::node_id i = 0; i < result.parent.size(); ++i) {
+      if (result.parent[i] != testgraph::bfs_result::no_parent) {
+        parent[testgraph::testgraph::node_locator(i)] =
+            the_graph.node_name(result.parent[i]);
       }
-      std::cout << "swapping\n";
-      std::swap(next_level, curr_level);
-      next_level.clear();
     }
   }
+
+  boost::json::object stats;
+  stats["visited"] = result.visited;
+  stats["depth"] = result.depth;
+  stats["edges_traversed"] = result.edges_traversed;
+  stats["seconds"] = secs;
+  stats["teps"] = secs > 0 ? double(result.edges_traversed) / secs : 0.0;
+
+  clip.set_state(state_name, the_graph);
+  clip.set_state(sel_state_name, selectors);
+  clip.update_selectors(selectors);
+  clip.to_return(stats);
+  return 0;
 }
@@ -0,0 +1,195 @@
+#pragma once
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include "adjacency.hpp"
+#include "parallel.hpp"
+
+namespace testgraph {
+
+// the result of a breadth-first search over node ids. Nodes it did not reach
+// have distance -1 and parent no_parent; the source is its own parent.
+struct bfs_result {
+  static constexpr mvmap::index no_parent =
+      std::numeric_limits<mvmap::index>::max();
+
+  std::vector<int64_t> distance;
+  std::vector<mvmap::index> parent;
+  size_t visited = 0;
+  int64_t depth = 0;
+  // out edges of the reached nodes, the numerator of traversed edges per
+  // second (TEPS).
+  size_t edges_traversed = 0;
+};
+
+namespace detail {
+
+// A set of node ids, one bit each, that threads can add to at once.
+class frontier_bitmap {
+  std::vector<std::atomic<uint64_t>> words;
+
+ public:
+  explicit frontier_bitmap(size_t n) : words((n + 63) / 64) {}
+
+  [[nodiscard]] size_t num_words() const { return words.size(); }
+
+  [[nodiscard]] bool contains(mvmap::index i) const {
+    return (words[i / 64].load(std::memory_order_relaxed) >> (i % 64)) & 1;
+  }
+  void insert(mvmap::index i) {
+    words[i / 64].fetch_or(uint64_t{1} << (i % 64), std::memory_order_relaxed);
+  }
+  [[nodiscard]] uint64_t word(size_t w) const {
+    return words[w].load(std::memory_order_relaxed);
+  }
+  void clear(size_t w) { words[w].store(0, std::memory_order_relaxed); }
+};
+
+}  // namespace detail
+
+// Tuning of the switch between top-down and bottom-up steps, from Beamer et
+// al., "Direction-Optimizing Breadth-First Search": go bottom-up once the
+// frontier has more than 1/alpha of the unexplored edges, and back top-down
+// once it holds fewer than 1/beta of the nodes.
+inline constexpr size_t bfs_alpha = 15;
+inline constexpr size_t bfs_beta = 18;
+
+// breadth-first search from source along the out edges, stopping after
+// max_depth levels if it is not negative. Each level is expanded over blocks
+// of the frontier bitmap on num_threads threads, either top-down (frontier
+// nodes claim their unvisited out neighbors) or bottom-up (unvisited nodes
+// look for a parent among their in neighbors), whichever should touch fewer
+// edges. in must be the transpose of out.
+inline bfs_result bfs(const csr &out, const csr &in, mvmap::index source,
+                      int64_t max_depth = -1, unsigned num_threads = 0,
+                      bool direction_optimizing = true) {
+  size_t n = out.num_rows();
+  bfs_result result;
+  result.distance.assign(n, -1);
+  result.parent.assign(n, bfs_result::no_parent);
+  if (source >= n) {
+    return result;
+  }
+
+  std::vector<std::atomic<mvmap::index>> parent(n);
+  for (auto &p : parent) {
+    p.store(bfs_result::no_parent, std::memory_order_relaxed);
+  }
+  detail::frontier_bitmap frontier(n);
+  detail::frontier_bitmap next(n);
+  size_t num_words = frontier.num_words();
+  num_threads = thread_count(out.num_entries() + n, num_threads);
+
+  parent[source].store(source, std::memory_order_relaxed);
+  result.distance[source] = 0;
+  frontier.insert(source);
+  size_t frontier_nodes = 1;
+  size_t frontier_edges = out.degree(source);
+  size_t unexplored_edges = in.num_entries() - in.degree(source);
+  result.visited = 1;
+  result.edges_traversed = frontier_edges;
+
+  // per-thread counts of the nodes added to next, and of their out and in
+  // edges.
+  struct level_counts {
+    size_t nodes = 0;
+    size_t out_edges = 0;
+    size_t in_edges = 0;
+  };
+  std::vector<level_counts> counts(num_threads);
+
+  bool bottom_up = false;
+  int64_t level = 0;
+  while (frontier_nodes > 0 && (max_depth < 0 || level < max_depth)) {
+    if (direction_optimizing) {
+      if (!bottom_up && frontier_edges > unexplored_edges / bfs_alpha) {
+        bottom_up = true;
+      } else if (bottom_up && frontier_nodes < n / bfs_beta) {
+        bottom_up = false;
+      }
+    }
+
+    std::fill(counts.begin(), counts.end(), level_counts{});
+    auto visit = [&](unsigned t, mvmap::index v) {
+      result.distance[v] = level + 1;
+      next.insert(v);
+      counts[t].nodes += 1;
+      counts[t].out_edges += out.degree(v);
+      counts[t].in_edges += in.degree(v);
+    };
+
+    if (bottom_up) {
+      // each thread owns the nodes of its words, so claims need no CAS.
+      parallel_blocks(
+          num_words, num_threads, [&](unsigned t, size_t lo, size_t hi) {
+            for (size_t w = lo; w < hi; ++w) {
+              for (auto v = w * 64; v < std::min(n, w * 64 + 64); ++v) {
+                if (parent[v].load(std::memory_order_relaxed) !=
+                    bfs_result::no_parent) {
+                  continue;
+                }
+                for (auto u : in.neighbors(v)) {
+                  if (frontier.contains(u)) {
+                    parent[v].store(u, std::memory_order_relaxed);
+                    visit(t, v);
+                    break;
+                  }
+                }
+              }
+            }
+          });
+    } else {
+      parallel_blocks(
+          num_words, num_threads, [&](unsigned t, size_t lo, size_t hi) {
+            for (size_t w = lo; w < hi; ++w) {
+              for (auto bits = frontier.word(w); bits != 0; bits &= bits - 1) {
+                mvmap::index u = w * 64 + std::countr_zero(bits);
+                for (auto v : out.neighbors(u)) {
+                  auto expected = bfs_result::no_parent;
+                  if (parent[v].load(std::memory_order_relaxed) == expected &&
+                      parent[v].compare_exchange_strong(
+                          expected, u, std::memory_order_relaxed)) {
+                    visit(t, v);
+                  }
+                }
+              }
+            }
+          });
+    }
+
+    auto total = std::accumulate(
+        counts.begin(), counts.end(), level_counts{},
+        [](level_counts a, const level_counts &b) {
+          return level_counts{a.nodes + b.nodes, a.out_edges + b.out_edges,
+                              a.in_edges + b.in_edges};
+        });
+    frontier_nodes = total.nodes;
+    frontier_edges = total.out_edges;
+    unexplored_edges -= total.in_edges;
+    result.visited += total.nodes;
+    result.edges_traversed += total.out_edges;
+    if (total.nodes > 0) {
+      ++level;
+    }
+
+    std::swap(frontier, next);
+    parallel_blocks(num_words, num_threads,
+                    [&next](unsigned /*t*/, size_t lo, size_t hi) {
+                      for (size_t w = lo; w < hi; ++w) {
+                        next.clear(w);
+                      }
+                    });
+  }
+
+  result.depth = level;
+  for (size_t i = 0; i < n; ++i) {
+    result.parent[i] = parent[i].load(std::memory_order_relaxed);
+  }
+  return result;
+}
+
+}  // namespace testgraph
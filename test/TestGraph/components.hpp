@@ -0,0 +1,205 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "adjacency.hpp"
+#include "parallel.hpp"
+
+namespace testgraph {
+
+// A union-find over node ids that any number of threads can unite in at
+// once. Roots are only ever linked below smaller roots, with a
+// compare-and-swap, so a component's root is its smallest id; find()
+// halves the paths it walks.
+class concurrent_union_find {
+  std::vector<std::atomic<mvmap::index>> parent;
+
+ public:
+  explicit concurrent_union_find(size_t n, unsigned num_threads = 0)
+      : parent(n) {
+    parallel_blocks(n, thread_count(n, num_threads),
+                    [this](unsigned /*t*/, size_t lo, size_t hi) {
+                      for (size_t i = lo; i < hi; ++i) {
+                        parent[i].store(i, std::memory_order_relaxed);
+                      }
+                    });
+  }
+
+  [[nodiscard]] size_t size() const { return parent.size(); }
+
+  mvmap::index find(mvmap::index i) {
+    auto p = parent[i].load(std::memory_order_relaxed);
+    while (p != i) {
+      auto gp = parent[p].load(std::memory_order_relaxed);
+      if (gp != p) {
+        // a racing update may win; either way i moves up the tree.
+        parent[i].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+      }
+      i = p;
+      p = parent[i].load(std::memory_order_relaxed);
+    }
+    return i;
+  }
+
+  void unite(mvmap::index a, mvmap::index b) {
+    while (true) {
+      a = find(a);
+      b = find(b);
+      if (a == b) {
+        return;
+      }
+      if (a < b) {
+        std::swap(a, b);
+      }
+      // a is the larger root; it fails to link if it is no longer a root.
+      auto expected = a;
+      if (parent[a].compare_exchange_strong(expected, b,
+                                            std::memory_order_acq_rel)) {
+        return;
+      }
+    }
+  }
+};
+
+// labels each node id with the smallest id in its (weakly) connected
+// component. The edges of each block of rows of the CSR are united on a
+// thread of their own, then every id is resolved to its root.
+inline std::vector<mvmap::index> connected_components(
+    const csr &edges, unsigned num_threads = 0) {
+  size_t n = edges.num_rows();
+  num_threads = thread_count(edges.num_entries(), num_threads);
+  concurrent_union_find uf(n, num_threads);
+  parallel_blocks(n, num_threads,
+                  [&edges, &uf](unsigned /*t*/, size_t lo, size_t hi) {
+                    for (auto u = lo; u < hi; ++u) {
+                      for (auto v : edges.neighbors(u)) {
+                        uf.unite(u, v);
+                      }
+                    }
+                  });
+  std::vector<mvmap::index> labels(n);
+  parallel_blocks(n, num_threads,
+                  [&labels, &uf](unsigned /*t*/, size_t lo, size_t hi) {
+                    for (auto i = lo; i < hi; ++i) {
+                      labels[i] = uf.find(i);
+                    }
+                  });
+  return labels;
+}
+
+// The components of a graph, kept up to date as its nodes and edges are
+// added so they need not be recomputed. Sets are linked by size with path
+// halving, so an update is nearly O(1); each root also keeps the smallest
+// id in its set, which labels the component as connected_components does.
+// Like adjacency, it records the key versions of the tables it was last
+// brought up to date with; any other change, such as removing an edge,
+// leaves it stale.
+class incremental_components {
+  std::vector<mvmap::index> parent;
+  std::vector<mvmap::index> set_size;
+  std::vector<mvmap::index> smallest;
+  uint64_t node_version = 0;
+  uint64_t edge_version = 0;
+
+  [[nodiscard]] mvmap::index root(mvmap::index i) const {
+    while (parent[i] != i) {
+      i = parent[i];
+    }
+    return i;
+  }
+
+ public:
+  incremental_components() = default;
+
+  // the components labels gives, as connected_components returns them.
+  explicit incremental_components(const std::vector<mvmap::index> &labels)
+      : parent(labels), set_size(labels.size(), 0), smallest(labels.size()) {
+    for (size_t i = 0; i < labels.size(); ++i) {
+      set_size[labels[i]] += 1;
+      smallest[i] = i;
+    }
+  }
+
+  [[nodiscard]] size_t size() const { return parent.size(); }
+
+  // adds singleton sets up to id n - 1.
+  void resize(size_t n) {
+    for (auto i = parent.size(); i < n; ++i) {
+      parent.push_back(i);
+      set_size.push_back(1);
+      smallest.push_back(i);
+    }
+  }
+
+  mvmap::index find(mvmap::index i) {
+    while (parent[i] != i) {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+    return i;
+  }
+
+  void unite(mvmap::index a, mvmap::index b) {
+    resize(std::max(a, b) + 1);
+    a = find(a);
+    b = find(b);
+    if (a == b) {
+      return;
+    }
+    if (set_size[a] < set_size[b]) {
+      std::swap(a, b);
+    }
+    parent[b] = a;
+    set_size[a] += set_size[b];
+    smallest[a] = std::min(smallest[a], smallest[b]);
+  }
+
+  // each id's label: the smallest id in its component.
+  [[nodiscard]] std::vector<mvmap::index> labels() const {
+    std::vector<mvmap::index> out(parent.size());
+    for (size_t i = 0; i < parent.size(); ++i) {
+      out[i] = smallest[root(i)];
+    }
+    return out;
+  }
+
+  template <typename NodeMap, typename EdgeMap>
+  [[nodiscard]] bool is_current(const NodeMap &nodes,
+                                const EdgeMap &edges) const {
+    return node_version == nodes.keys_version() &&
+           edge_version == edges.keys_version();
+  }
+
+  // records that the sets are those of the tables as they are now.
+  template <typename NodeMap, typename EdgeMap>
+  void stamp(const NodeMap &nodes, const EdgeMap &edges) {
+    resize(nodes.index_capacity());
+    node_version = nodes.keys_version();
+    edge_version = edges.keys_version();
+  }
+
+  // only the labels are saved; the sets are rebuilt from them on loading.
+  friend void tag_invoke(boost::json::value_from_tag /*unused*/,
+                         boost::json::value &v,
+                         const incremental_components &c) {
+    v = {{"labels", boost::json::value_from(c.labels())},
+         {"node_version", c.node_version},
+         {"edge_version", c.edge_version}};
+  }
+
+  friend incremental_components tag_invoke(
+      boost::json::value_to_tag<incremental_components> /*unused*/,
+      const boost::json::value &v) {
+    const auto &obj = v.as_object();
+    incremental_components c(
+        boost::json::value_to<std::vector<mvmap::index>>(obj.at("labels")));
+    c.node_version = boost::json::value_to<uint64_t>(obj.at("node_version"));
+    c.edge_version = boost::json::value_to<uint64_t>(obj.at("edge_version"));
+    return c;
+  }
+};
+
+}  // namespace testgraph
@@ -9,7 +9,6 @@
 #include <clippy/clippy.hpp>
 #include <iostream>
 #include <jsonlogic/src.hpp>
-#include <queue>
 
 #include "testgraph.hpp"
 
@@ -73,48 +72,18 @@ int main(int argc, char **argv) {
   }
 
   auto cc = cc_o.value();
-  std::map<testgraph::node_t, int64_t> ccmap;
 
-  int64_t i = 0;
-  for (auto &node : the_graph.nodes()) {
-    ccmap[node] = i++;
-  }
-  std::vector<std::vector<int64_t>> adj(the_graph.nv());
-  the_graph.for_all_edges([&adj, &ccmap](auto edge, mvmap::locator /*unused*/) {
-    long i = ccmap[edge.first];
-    long j = ccmap[edge.second];
-    adj[i].push_back(j);
-    adj[j].push_back(i);
-  });
-
-  std::vector<bool> visited(the_graph.nv(), false);
-  std::vector<int64_t> components(the_graph.nv());
-  std::iota(components.begin(), components.end(), 0);
-
-  for (int64_t i = 0; i < the_graph.nv(); ++i) {
-    if (!visited[i]) {
-      std::queue<int64_t> q;
-      q.push(i);
-      while (!q.empty()) {
-        int64_t v = q.front();
-        q.pop();
-        visited[v] = true;
-        for (int64_t u : adj[v]) {
-          if (!visited[u]) {
-            q.push(u);
-            components[u] = components[i];
-          }
-        }
-      }
+  // components are numbered by the smallest node id in them.
+  const auto &nodes = the_graph.nodemap();
+  auto components = the_graph.component_labels();
+  size_t n = components.size();
+
+  for (testgraph::node_id i = 0; i < n; ++i) {
+    if (nodes.has_key_at(i)) {
+      cc[testgraph::testgraph::node_locator(i)] = int64_t(components[i]);
     }
   }
 
-  the_graph.for_all_nodes(
-      [&components, &ccmap, &cc](auto node, mvmap::locator /*unused*/) {
-        int64_t i = ccmap[node];
-        cc[node] = components[i];
-      });
-
   clip.set_state(state_name, the_graph);
   // clip.set_state(sel_state_name, selectors);
   // clip.update_selectors(selectors);
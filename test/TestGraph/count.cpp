@@ -8,6 +8,7 @@
 #include <clippy/clippy.hpp>
 #include <iostream>
 #include <jsonlogic/src.hpp>
+#include <optional>
 #include <variant>
 
 #include "clippy/selector.hpp"
@@ -17,12 +18,41 @@ static const std::string method_name = "count";
 static const std::string state_name = "INTERNAL";
 static const std::string sel_state_name = "selectors";
 
+namespace {
+
+// the count of each value of the series, or if k > 0 the k most frequent
+// values and their counts, most frequent first.
+template <typename Series>
+boost::json::value count_of(const Series &ser, int64_t k) {
+  if (k > 0) {
+    return boost::json::value_from(ser.top_counts(size_t(k)));
+  }
+  return boost::json::value_from(ser.count());
+}
+
+// returns the counts of the series if it holds values of type V.
+template <typename V>
+std::optional<boost::json::value> count_as(testgraph::testgraph &g,
+                                           bool is_edge,
+                                           const std::string &sel, int64_t k) {
+  if (is_edge) {
+    auto ser = g.get_edge_series<V>(sel);
+    return ser ? std::optional(count_of(*ser, k)) : std::nullopt;
+  }
+  auto ser = g.get_node_series<V>(sel);
+  return ser ? std::optional(count_of(*ser, k)) : std::nullopt;
+}
+
+}  // namespace
+
 int main(int argc, char **argv) {
   clippy::clippy clip{method_name,
                       "returns a map containing the count of values in a "
                       "series based on selector"};
   clip.add_required<selector>("selector",
                               "Existing selector name to calculate extrema");
+  clip.add_optional<int64_t>(
+      "k", "If positive, return only the k most frequent values", 0);
   clip.add_required_state<testgraph::testgraph>(state_name,
                                                 "Internal container");
 
@@ -32,6 +62,7 @@ int main(int argc, char **argv) {
   }
   auto sel_str = clip.get<selector>("selector");
   selector sel{sel_str};
+  auto k = clip.get<int64_t>("k");
 
   auto the_graph = clip.get_state<testgraph::testgraph>(state_name);
 
@@ -51,74 +82,21 @@ int main(int argc, char **argv) {
   }
 
   auto tail_sel = tailsel_opt.value();
-  if (is_edge_sel) {
-    if (the_graph.has_series<bool>(sel)) {
-      auto series = the_graph.get_edge_series<bool>(tail_sel);
-      if (series) {
-        clip.to_return<std::map<bool, size_t>>(series.value().count());
-      } else {
-        clip.to_return<std::map<bool, size_t>>({});
-      }
-    } else if (the_graph.has_series<int64_t>(sel)) {
-      auto series = the_graph.get_edge_series<int64_t>(tail_sel);
-      if (series) {
-        clip.to_return<std::map<int64_t, size_t>>(series.value().count());
-      } else {
-        clip.to_return<std::map<int64_t, size_t>>({});
-      }
-    } else if (the_graph.has_series<double>(sel)) {
-      auto series = the_graph.get_edge_series<double>(tail_sel);
-      if (series) {
-        clip.to_return<std::map<double, size_t>>(series.value().count());
-      } else {
-        clip.to_return<std::map<double, size_t>>({});
-      }
-    } else if (the_graph.has_series<std::string>(sel)) {
-      auto series = the_graph.get_edge_series<std::string>(tail_sel);
-      if (series) {
-        clip.to_return<std::map<std::string, size_t>>(series.value().count());
-      } else {
-        clip.to_return<std::map<std::string, size_t>>({});
-      }
-    } else {
-      std::cerr << "UNKNOWN TYPE" << std::endl;
-      return 1;
-    }
-  } else if (is_node_sel) {
-    if (the_graph.has_series<bool>(sel)) {
-      sel = tailsel_opt.value();
-      auto series = the_graph.get_node_series<bool>(tail_sel);
-      if (series) {
-        clip.to_return<std::map<bool, size_t>>(series.value().count());
-      } else {
-        clip.to_return<std::map<bool, size_t>>({});
-      }
-    } else if (the_graph.has_series<int64_t>(sel)) {
-      auto series = the_graph.get_node_series<int64_t>(tail_sel);
-      if (series) {
-        clip.to_return<std::map<int64_t, size_t>>(series.value().count());
-      } else {
-        clip.to_return<std::map<int64_t, size_t>>({});
-      }
-    } else if (the_graph.has_series<double>(sel)) {
-      auto series = the_graph.get_node_series<double>(tail_sel);
-      if (series) {
-        clip.to_return<std::map<double, size_t>>(series.value().count());
-      } else {
-        clip.to_return<std::map<double, size_t>>({});
-      }
-    } else if (the_graph.has_series<std::string>(sel)) {
-      auto series = the_graph.get_node_series<std::string>(tail_sel);
-      if (series) {
-        clip.to_return<std::map<std::string, size_t>>(series.value().count());
-      } else {
-        clip.to_return<std::map<std::string, size_t>>({});
-      }
-    } else {
-      std::cerr << "UNKNOWN TYPE" << std::endl;
-      return 1;
-    }
+  auto counts = count_as<bool>(the_graph, is_edge_sel, tail_sel, k);
+  if (!counts) {
+    counts = count_as<int64_t>(the_graph, is_edge_sel, tail_sel, k);
+  }
+  if (!counts) {
+    counts = count_as<double>(the_graph, is_edge_sel, tail_sel, k);
+  }
+  if (!counts) {
+    counts = count_as<std::string>(the_graph, is_edge_sel, tail_sel, k);
+  }
+  if (!counts) {
+    std::cerr << "UNKNOWN TYPE" << std::endl;
+    return 1;
   }
+  clip.to_return(*counts);
   clip.set_state(state_name, the_graph);
   return 0;
 }
@@ -62,12 +62,14 @@ int main(int argc, char **argv) {
 
   auto deg = deg_o.value();
 
-  the_graph.for_all_edges([&deg](auto edge, mvmap::locator /*unused*/) {
-    deg[edge.first]++;
-    if (edge.first != edge.second) {
-      deg[edge.second]++;
-    }
-  });
+  // nodes without edges are left out of the series.
+  const auto &adj = the_graph.adjacency_index();
+  the_graph.for_all_nodes(
+      [&the_graph, &adj, &deg](const auto &node, mvmap::locator loc) {
+        if (auto d = adj.degree(the_graph.node_index(node)); d > 0) {
+          deg[loc] = int64_t(d);
+        }
+      });
 
   clip.set_state(state_name, the_graph);
   clip.set_state(sel_state_name, selectors);
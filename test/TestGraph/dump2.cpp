@@ -84,6 +84,5 @@ int main(int argc, char **argv) {
       "map of key: value corresponding to the selector");
 
   clip.to_return(std::map<std::string, bool>{});
-  clip.set_state(state_name, the_graph);
   return 0;
 }
@@ -0,0 +1,293 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "../include/binary_io.hpp"
+#include "parallel.hpp"
+
+namespace testgraph {
+
+// Edge list files hold one edge per line, as its source and destination node
+// names, and optionally its weight, separated by whitespace (tsv) or a comma
+// (csv); further fields are ignored, as are blank lines and lines starting
+// with '#' or '%'. A binary edge list is packed pairs of little-endian
+// uint64 node numbers, which name the nodes in decimal.
+enum class edge_list_format { tsv, csv, binary };
+
+// the format a file name implies: csv for .csv, binary for .bin, or else
+// tsv.
+inline edge_list_format edge_list_format_of(std::string_view path) {
+  if (path.ends_with(".csv")) {
+    return edge_list_format::csv;
+  }
+  if (path.ends_with(".bin")) {
+    return edge_list_format::binary;
+  }
+  return edge_list_format::tsv;
+}
+
+// the format named "tsv", "csv" or "binary", or else nullopt.
+inline std::optional<edge_list_format> edge_list_format_named(
+    std::string_view name) {
+  if (name == "tsv") {
+    return edge_list_format::tsv;
+  }
+  if (name == "csv") {
+    return edge_list_format::csv;
+  }
+  if (name == "binary") {
+    return edge_list_format::binary;
+  }
+  return std::nullopt;
+}
+
+// the format named name, or the one path implies if name is empty. Throws
+// std::runtime_error if name isn't a format.
+inline edge_list_format resolve_edge_list_format(std::string_view path,
+                                                 std::string_view name) {
+  if (name.empty()) {
+    return edge_list_format_of(path);
+  }
+  auto named = edge_list_format_named(name);
+  if (!named) {
+    throw std::runtime_error("Unknown edge list format " + std::string(name));
+  }
+  return *named;
+}
+
+// The edges of an edge list: endpoint names 2 * i and 2 * i + 1 are the
+// source and destination of edge i. Names are views into the mapped file, or
+// into owned for a binary list. weights is empty unless they were asked for.
+struct edge_list {
+  std::unique_ptr<mvmap::binary::mapped_file> file;
+  std::vector<std::string> owned;
+  std::vector<std::string_view> names;
+  std::vector<double> weights;
+  size_t bytes = 0;
+
+  [[nodiscard]] size_t size() const { return names.size() / 2; }
+};
+
+namespace detail {
+
+// The characters that end a field: whitespace for tsv, a comma for csv, and
+// a newline for both. Finding the next one is the inner loop of parsing, so
+// with SSE2 it compares 16 bytes at a time.
+class separators {
+  char seps[4];
+
+ public:
+  explicit separators(edge_list_format format)
+      : seps{'\n', '\r', format == edge_list_format::csv ? ',' : ' ',
+             format == edge_list_format::csv ? ',' : '\t'} {}
+
+  [[nodiscard]] bool contains(char c) const {
+    return c == seps[0] || c == seps[1] || c == seps[2] || c == seps[3];
+  }
+
+  // the first separator in [p, last), or last.
+  template <bool Simd = true>
+  const char *find(const char *p, const char *last) const {
+#if defined(__SSE2__)
+    if constexpr (Simd) {
+      const __m128i s0 = _mm_set1_epi8(seps[0]);
+      const __m128i s1 = _mm_set1_epi8(seps[1]);
+      const __m128i s2 = _mm_set1_epi8(seps[2]);
+      const __m128i s3 = _mm_set1_epi8(seps[3]);
+      for (; last - p >= 16; p += 16) {
+        __m128i block =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        __m128i hits =
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, s0),
+                                      _mm_cmpeq_epi8(block, s1)),
+                         _mm_or_si128(_mm_cmpeq_epi8(block, s2),
+                                      _mm_cmpeq_epi8(block, s3)));
+        if (auto mask = unsigned(_mm_movemask_epi8(hits)); mask != 0) {
+          return p + std::countr_zero(mask);
+        }
+      }
+    }
+#endif
+    while (p != last && !contains(*p)) {
+      ++p;
+    }
+    return p;
+  }
+};
+
+inline bool is_blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+inline std::string_view trim(const char *first, const char *last) {
+  while (first != last && is_blank(*first)) {
+    ++first;
+  }
+  while (last != first && is_blank(last[-1])) {
+    --last;
+  }
+  return {first, size_t(last - first)};
+}
+
+// The edges parsed from one chunk of the text.
+struct partial_edges {
+  std::vector<std::string_view> names;
+  std::vector<double> weights;
+  // the offset of the first malformed line, if any.
+  size_t bad = std::string_view::npos;
+};
+
+// parses the lines that start in [lo, hi) of text.
+template <bool Simd>
+void parse_lines(std::string_view text, size_t lo, size_t hi,
+                 edge_list_format format, bool weighted,
+                 partial_edges &out) {
+  const separators seps(format);
+  const char *base = text.data();
+  const char *last = base + text.size();
+  const size_t want = weighted ? 3 : 2;
+  std::string_view fields[3];
+  for (const char *p = base + lo; p < base + hi;) {
+    const char *line = p;
+    size_t found = 0;
+    // fields end at a separator; tsv fields may be separated by several.
+    while (p != last && *p != '\n') {
+      if (*p == '\r' || (format == edge_list_format::tsv && is_blank(*p))) {
+        ++p;
+        continue;
+      }
+      const char *end = seps.find<Simd>(p, last);
+      if (found < want) {
+        fields[found] = format == edge_list_format::csv
+                            ? trim(p, end)
+                            : std::string_view(p, size_t(end - p));
+      }
+      ++found;
+      p = end;
+      if (p != last && *p == ',') {
+        ++p;
+      }
+    }
+    p = p == last ? last : p + 1;
+    if (found == 0 || fields[0].empty() || fields[0][0] == '#' ||
+        fields[0][0] == '%') {
+      continue;
+    }
+    double w = 0;
+    if (found < want ||
+        (weighted && std::from_chars(fields[2].data(),
+                                     fields[2].data() + fields[2].size(), w)
+                             .ec != std::errc{})) {
+      out.bad = size_t(line - base);
+      return;
+    }
+    out.names.push_back(fields[0]);
+    out.names.push_back(fields[1]);
+    if (weighted) {
+      out.weights.push_back(w);
+    }
+  }
+}
+
+}  // namespace detail
+
+// tokenizes a text edge list into list, in file order. The text is split
+// into one chunk per thread at line boundaries; each thread parses its chunk
+// into arrays of its own, which are merged at the end. Throws
+// std::runtime_error at a line with too few fields or a bad weight.
+template <bool Simd = true>
+void parse_edge_list(std::string_view text, edge_list_format format,
+                     bool weighted, edge_list &list,
+                     unsigned num_threads = 0) {
+  num_threads = thread_count(text.size() / 16, num_threads);
+  std::vector<detail::partial_edges> parts(num_threads);
+  // a chunk owns the lines that start in it.
+  auto line_start = [text](size_t pos) {
+    if (pos == 0 || pos >= text.size()) {
+      return std::min(pos, text.size());
+    }
+    auto nl = text.find('\n', pos - 1);
+    return nl == std::string_view::npos ? text.size() : nl + 1;
+  };
+  parallel_blocks(text.size(), num_threads,
+                  [&](unsigned t, size_t lo, size_t hi) {
+                    detail::parse_lines<Simd>(text, line_start(lo),
+                                              line_start(hi), format,
+                                              weighted, parts[t]);
+                  });
+
+  size_t num_names = 0;
+  for (const auto &part : parts) {
+    if (part.bad != std::string_view::npos) {
+      throw std::runtime_error("malformed edge list line at byte " +
+                               std::to_string(part.bad));
+    }
+    num_names += part.names.size();
+  }
+  list.names.reserve(list.names.size() + num_names);
+  list.weights.reserve(list.weights.size() + num_names / 2);
+  for (const auto &part : parts) {
+    list.names.insert(list.names.end(), part.names.begin(), part.names.end());
+    list.weights.insert(list.weights.end(), part.weights.begin(),
+                        part.weights.end());
+  }
+  list.bytes += text.size();
+}
+
+// reads a packed binary edge list into list; its names are owned.
+inline void parse_binary_edges(std::span<const std::byte> bytes,
+                               edge_list &list, unsigned num_threads = 0) {
+  if (bytes.size() % (2 * sizeof(uint64_t)) != 0) {
+    throw std::runtime_error("binary edge list is not whole uint64 pairs");
+  }
+  size_t n = 2 * (bytes.size() / (2 * sizeof(uint64_t)));
+  list.owned.resize(n);
+  parallel_blocks(n, thread_count(n, num_threads),
+                  [&bytes, &list](unsigned /*t*/, size_t lo, size_t hi) {
+                    for (auto j = lo; j < hi; ++j) {
+                      uint64_t end = 0;
+                      std::memcpy(&end, bytes.data() + j * sizeof(end),
+                                  sizeof(end));
+                      list.owned[j] =
+                          std::to_string(mvmap::binary::little_endian(end));
+                    }
+                  });
+  list.names.assign(list.owned.begin(), list.owned.end());
+  list.bytes += bytes.size();
+}
+
+// maps an edge list file into memory and parses it. The names stay views
+// into the mapping, which the list keeps open. Binary lists have no weights.
+inline edge_list read_edge_list(const std::string &path,
+                                edge_list_format format, bool weighted = false,
+                                unsigned num_threads = 0) {
+  edge_list list;
+  list.file = std::make_unique<mvmap::binary::mapped_file>(path);
+  auto bytes = list.file->bytes();
+  if (format == edge_list_format::binary) {
+    if (weighted) {
+      throw std::runtime_error("binary edge lists have no weights");
+    }
+    parse_binary_edges(bytes, list, num_threads);
+  } else {
+    parse_edge_list(
+        {reinterpret_cast<const char *>(bytes.data()), bytes.size()}, format,
+        weighted, list, num_threads);
+  }
+  return list;
+}
+
+}  // namespace testgraph
@@ -1,4 +1,3 @@
-
 // Copyright 2021 Lawrence Livermore National Security, LLC and other CLIPPy
 // Project Developers. See the top-level COPYRIGHT file for details.
 //
@@ -6,8 +5,10 @@
 
 #include <boost/json.hpp>
 #include <clippy/clippy.hpp>
+#include <functional>
 #include <iostream>
-#include <jsonlogic/src.hpp>
+#include <map>
+#include <optional>
 
 #include "clippy/selector.hpp"
 #include "testgraph.hpp"
@@ -16,6 +17,44 @@ static const std::string method_name = "extrema";
 static const std::string state_name = "INTERNAL";
 static const std::string sel_state_name = "selectors";
 
+namespace {
+
+using extrema_t = std::map<std::string, boost::json::value>;
+
+// returns the (key, value) pairs of the minimum and maximum of a series,
+// with each key converted by name. The series' statistics are maintained
+// from then on, so later calls are O(1).
+template <typename Series, typename KeyName>
+extrema_t extrema_of(Series ser, KeyName name) {
+  ser.track_stats();
+  auto [min_tup, max_tup] = ser.extrema();
+  extrema_t extrema;
+  if (min_tup) {
+    extrema["min"] = boost::json::value_from(
+        std::make_pair(name(std::get<1>(*min_tup)), std::get<0>(*min_tup)));
+  }
+  if (max_tup) {
+    extrema["max"] = boost::json::value_from(
+        std::make_pair(name(std::get<1>(*max_tup)), std::get<0>(*max_tup)));
+  }
+  return extrema;
+}
+
+// returns the extrema of the series if it holds values of type V.
+template <typename V>
+std::optional<extrema_t> extrema_as(testgraph::testgraph &g, bool is_edge,
+                                    const std::string &sel) {
+  if (is_edge) {
+    auto ser = g.get_edge_series<V>(sel);
+    auto name = [&g](const auto &key) { return g.edge_name(key); };
+    return ser ? std::optional(extrema_of(*ser, name)) : std::nullopt;
+  }
+  auto ser = g.get_node_series<V>(sel);
+  return ser ? std::optional(extrema_of(*ser, std::identity{})) : std::nullopt;
+}
+
+}  // namespace
+
 int main(int argc, char **argv) {
   clippy::clippy clip{method_name,
                       "returns the extrema of a series based on selector"};
@@ -23,6 +62,7 @@ int main(int argc, char **argv) {
                               "Existing selector name to calculate extrema");
   clip.add_required_state<testgraph::testgraph>(state_name,
                                                 "Internal container");
+  clip.returns<extrema_t>("min and max keys and values of the series");
 
   // no object-state requirements in constructor
   if (clip.parse(argc, argv)) {
@@ -49,106 +89,16 @@ int main(int argc, char **argv) {
 
   auto the_graph = clip.get_state<testgraph::testgraph>(state_name);
 
-  if (is_edge_sel) {
-    clip.returns<std::map<std::string, std::pair<testgraph::edge_t, double>>>(
-        "min and max keys and values of the series");
-    if (the_graph.has_edge_series<double>(tail_sel)) {
-      auto series = the_graph.get_edge_series<double>(tail_sel);
-      if (!series) {
-        std::cerr << "Edge series not found" << std::endl;
-        return 1;
-      }
-      auto series_val = series.value();
-      auto [min_tup, max_tup] = series_val.extrema();
-
-      std::map<std::string, std::pair<testgraph::edge_t, double>> extrema;
-      if (min_tup) {
-        extrema["min"] = std::make_pair(std::get<1>(min_tup.value()),
-                                        std::get<0>(min_tup.value()));
-      }
-
-      if (max_tup) {
-        extrema["max"] = std::make_pair(std::get<1>(max_tup.value()),
-                                        std::get<0>(max_tup.value()));
-      }
-      clip.to_return(extrema);
-    } else if (the_graph.has_edge_series<int64_t>(tail_sel)) {
-      auto series = the_graph.get_edge_series<int64_t>(tail_sel);
-      if (!series) {
-        std::cerr << "Edge series not found" << std::endl;
-        return 1;
-      }
-      auto series_val = series.value();
-      auto [min_tup, max_tup] = series_val.extrema();
-
-      std::map<std::string, std::pair<testgraph::edge_t, double>> extrema;
-      if (min_tup) {
-        extrema["min"] = std::make_pair(std::get<1>(min_tup.value()),
-                                        std::get<0>(min_tup.value()));
-      }
-
-      if (max_tup) {
-        extrema["max"] = std::make_pair(std::get<1>(max_tup.value()),
-                                        std::get<0>(max_tup.value()));
-      }
-      clip.to_return(extrema);
-    } else {
-      std::cerr << "Edge series is an invalid type" << std::endl;
-      return 1;
-    }
-  } else if (is_node_sel) {
-    if (the_graph.has_edge_series<double>(tail_sel)) {
-      clip.returns<std::map<std::string, std::pair<testgraph::node_t, double>>>(
-          "min and max keys and values of the series");
-
-      auto series = the_graph.get_node_series<int64_t>(tail_sel);
-      if (!series) {
-        std::cerr << "Edge series not found" << std::endl;
-        return 1;
-      }
-
-      auto series_val = series.value();
-      auto [min_tup, max_tup] = series_val.extrema();
-
-      std::map<std::string, std::pair<testgraph::node_t, double>> extrema;
-      if (min_tup) {
-        extrema["min"] = std::make_pair(std::get<1>(min_tup.value()),
-                                        std::get<0>(min_tup.value()));
-      }
-      if (max_tup) {
-        extrema["max"] = std::make_pair(std::get<1>(max_tup.value()),
-                                        std::get<0>(max_tup.value()));
-      }
-
-      clip.to_return(extrema);
-    } else if (the_graph.has_node_series<int64_t>(tail_sel)) {
-      clip.returns<
-          std::map<std::string, std::pair<testgraph::node_t, int64_t>>>(
-          "min and max keys and values of the series");
-
-      auto series = the_graph.get_node_series<int64_t>(tail_sel);
-      if (!series) {
-        return 1;
-      }
-      auto series_val = series.value();
-      auto [min_tup, max_tup] = series_val.extrema();
-
-      std::map<std::string, std::pair<testgraph::node_t, int64_t>> extrema;
-      if (min_tup) {
-        extrema["min"] = std::make_pair(std::get<1>(min_tup.value()),
-                                        std::get<0>(min_tup.value()));
-      }
-      if (max_tup) {
-        extrema["max"] = std::make_pair(std::get<1>(max_tup.value()),
-                                        std::get<0>(max_tup.value()));
-      }
-
-      clip.to_return(extrema);
-    } else {
-      std::cerr << "Node series is an invalid type" << std::endl;
-      return 1;
-    }
+  auto extrema = extrema_as<double>(the_graph, is_edge_sel, tail_sel);
+  if (!extrema) {
+    extrema = extrema_as<int64_t>(the_graph, is_edge_sel, tail_sel);
+  }
+  if (!extrema) {
+    std::cerr << (is_edge_sel ? "Edge" : "Node")
+              << " series is an invalid type" << std::endl;
+    return 1;
   }
+  clip.to_return(*extrema);
 
   clip.set_state(state_name, the_graph);
   return 0;
@@ -0,0 +1,86 @@
+
+// Copyright 2021 Lawrence Livermore National Security, LLC and other CLIPPy
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <boost/json.hpp>
+#include <clippy/clippy.hpp>
+#include <iostream>
+#include <jsonlogic/src.hpp>
+#include <map>
+
+#include "clippy/selector.hpp"
+#include "kcore.hpp"
+#include "testgraph.hpp"
+
+static const std::string method_name = "kcore";
+static const std::string state_name = "INTERNAL";
+static const std::string sel_state_name = "selectors";
+
+int main(int argc, char **argv) {
+  clippy::clippy clip{
+      method_name,
+      "Populates a column containing the core number of each node"};
+  clip.add_required<selector>(
+      "selector",
+      "Existing selector name into which the core number will be written");
+  clip.add_required_state<testgraph::testgraph>(state_name,
+                                                "Internal container");
+  clip.add_required_state<std::map<std::string, std::string>>(
+      sel_state_name, "Internal container for pending selectors");
+  clip.returns<int64_t>("The largest core number, the degeneracy of the graph");
+  // no object-state requirements in constructor
+  if (clip.parse(argc, argv)) {
+    return 0;
+  }
+
+  selector sel = clip.get<selector>("selector");
+
+  if (!sel.headeq("node")) {
+    std::cerr << "Selector must be a node subselector" << std::endl;
+    return 1;
+  }
+  auto the_graph = clip.get_state<testgraph::testgraph>(state_name);
+
+  auto selectors =
+      clip.get_state<std::map<std::string, std::string>>(sel_state_name);
+  if (!selectors.contains(sel)) {
+    std::cerr << "Selector not found" << std::endl;
+    return 1;
+  }
+  auto subsel = sel.tail().value();
+  if (the_graph.has_node_series(subsel)) {
+    std::cerr << "Selector already populated" << std::endl;
+    return 1;
+  }
+
+  auto core_o = the_graph.add_node_series<int64_t>(subsel, "Core number");
+  if (!core_o) {
+    std::cerr << "Unable to manifest node series" << std::endl;
+    return 1;
+  }
+
+  auto core = core_o.value();
+
+  // edges are taken as undirected; self-loops and parallel edges are ignored.
+  const auto &adj = the_graph.adjacency_index();
+  auto cores = testgraph::core_numbers(
+      testgraph::undirected(adj.out_edges(), adj.in_edges()));
+  const auto &nodes = the_graph.nodemap();
+  int64_t result = 0;
+  for (testgraph::node_id i = 0; i < cores.size(); ++i) {
+    if (nodes.has_key_at(i)) {
+      core[testgraph::testgraph::node_locator(i)] = int64_t(cores[i]);
+      result = std::max(result, int64_t(cores[i]));
+    }
+  }
+
+  clip.set_state(state_name, the_graph);
+  clip.set_state(sel_state_name, selectors);
+  clip.update_selectors(selectors);
+
+  clip.to_return(result);
+  return 0;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "adjacency.hpp"
+#include "parallel.hpp"
+
+namespace testgraph {
+
+// the core number of each node of a simple undirected graph, such as
+// undirected() returns: the largest k such that the node is in a subgraph
+// where every node has degree at least k.
+//
+// Nodes are peeled in rounds k = 0, 1, ...: the nodes of degree k are
+// removed together, in parallel, which may bring neighbors down to degree k
+// to be removed next. Nodes wait in buckets by degree; a node whose degree
+// drops but stays above k is moved to its new bucket, and is skipped in its
+// old one.
+inline std::vector<uint64_t> core_numbers(const csr &g,
+                                          unsigned num_threads = 0) {
+  size_t n = g.num_rows();
+  num_threads = thread_count(g.num_entries() + n, num_threads);
+
+  std::vector<std::atomic<uint64_t>> degree(n);
+  std::vector<std::vector<mvmap::index>> buckets;
+  for (mvmap::index v = 0; v < n; ++v) {
+    auto d = g.degree(v);
+    degree[v].store(d, std::memory_order_relaxed);
+    if (d >= buckets.size()) {
+      buckets.resize(d + 1);
+    }
+    buckets[d].push_back(v);
+  }
+
+  std::vector<uint64_t> core(n, 0);
+  std::vector<uint8_t> removed(n, 0);
+  // per thread, the nodes brought down to degree k and the (degree, node)
+  // moves to later buckets.
+  std::vector<std::vector<mvmap::index>> next(num_threads);
+  std::vector<std::vector<std::pair<uint64_t, mvmap::index>>> moves(
+      num_threads);
+
+  for (uint64_t k = 0; k < buckets.size(); ++k) {
+    std::vector<mvmap::index> frontier;
+    for (auto v : buckets[k]) {
+      if (removed[v] == 0 &&
+          degree[v].load(std::memory_order_relaxed) == k) {
+        frontier.push_back(v);
+      }
+    }
+    std::vector<mvmap::index>().swap(buckets[k]);
+
+    while (!frontier.empty()) {
+      for (auto v : frontier) {
+        removed[v] = 1;
+        core[v] = k;
+      }
+      parallel_blocks(
+          frontier.size(), thread_count(frontier.size(), num_threads),
+          [&](unsigned t, size_t lo, size_t hi) {
+            for (auto f = lo; f < hi; ++f) {
+              for (auto u : g.neighbors(frontier[f])) {
+                if (removed[u] != 0) {
+                  continue;
+                }
+                auto d =
+                    degree[u].fetch_sub(1, std::memory_order_relaxed) - 1;
+                if (d == k) {
+                  next[t].push_back(u);
+                } else if (d > k) {
+                  moves[t].emplace_back(d, u);
+                }
+              }
+            }
+          });
+      frontier.clear();
+      for (unsigned t = 0; t < num_threads; ++t) {
+        frontier.insert(frontier.end(), next[t].begin(), next[t].end());
+        next[t].clear();
+        for (auto [d, u] : moves[t]) {
+          buckets[d].push_back(u);
+        }
+        moves[t].clear();
+      }
+    }
+  }
+  return core;
+}
+
+}  // namespace testgraph
@@ -0,0 +1,101 @@
+// Copyright 2021 Lawrence Livermore National Security, LLC and other CLIPPy
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <boost/json.hpp>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+#include "clippy/clippy.hpp"
+#include "clippy/selector.hpp"
+#include "edge_list.hpp"
+#include "testgraph.hpp"
+
+static const std::string method_name = "load_edge_list";
+static const std::string state_name = "INTERNAL";
+static const std::string sel_state_name = "selectors";
+
+int main(int argc, char **argv) {
+  clippy::clippy clip{method_name,
+                      "Memory-maps an edge list file and inserts its edges "
+                      "(and optionally their weights) into a TestGraph"};
+  clip.add_required<std::string>(
+      "path", "Local edge list file: tsv, csv (.csv) or binary pairs (.bin)");
+  clip.add_optional<std::string>(
+      "format", "tsv, csv or binary; by default implied by the file name", "");
+  clip.add_optional<boost::json::object>(
+      "weight",
+      "Existing selector name into which the third column is written as "
+      "the edge weight",
+      boost::json::object{});
+  clip.add_required_state<testgraph::testgraph>(state_name,
+                                                "Internal container");
+  clip.add_required_state<std::map<std::string, std::string>>(
+      sel_state_name, "Internal container for pending selectors");
+  clip.returns<boost::json::object>(
+      "Bytes read, edges read, seconds and load throughput in MB/s");
+
+  // no object-state requirements in constructor
+  if (clip.parse(argc, argv)) {
+    return 0;
+  }
+
+  auto path = clip.get<std::string>("path");
+  auto format_name = clip.get<std::string>("format");
+  auto the_graph = clip.get_state<testgraph::testgraph>(state_name);
+  auto selectors =
+      clip.get_state<std::map<std::string, std::string>>(sel_state_name);
+
+  std::optional<std::string> weight_name;
+  if (clip.has_argument("weight")) {
+    selector sel(clip.get<boost::json::object>("weight"));
+    if (!sel.headeq("edge")) {
+      std::cerr << "Selector must be an edge subselector" << std::endl;
+      return 1;
+    }
+    if (!selectors.contains(sel)) {
+      std::cerr << "Selector not found" << std::endl;
+      return 1;
+    }
+    weight_name = sel.tail().value();
+    if (the_graph.has_edge_series(*weight_name)) {
+      std::cerr << "Selector already populated" << std::endl;
+      return 1;
+    }
+  }
+
+  // the time to map, parse and insert; throughput is over the file's bytes.
+  auto start = std::chrono::steady_clock::now();
+  testgraph::edge_list list;
+  try {
+    auto format = testgraph::resolve_edge_list_format(path, format_name);
+    list = testgraph::read_edge_list(path, format, weight_name.has_value());
+    the_graph.add_edges(list, weight_name);
+  } catch (const std::runtime_error &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                              start)
+                    .count();
+
+  boost::json::object stats;
+  stats["bytes"] = list.bytes;
+  stats["edges"] = list.size();
+  stats["seconds"] = secs;
+  stats["mb_per_s"] = secs > 0 ? double(list.bytes) / 1e6 / secs : 0.0;
+
+  clip.set_state(state_name, the_graph);
+  // the graph can be large, and this process exits once it is saved, so it
+  // isn't torn down.
+  the_graph.forget();
+  clip.set_state(sel_state_name, selectors);
+  clip.update_selectors(selectors);
+  clip.to_return(stats);
+  return 0;
+}
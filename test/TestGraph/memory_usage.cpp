@@ -0,0 +1,33 @@
+// Copyright 2021 Lawrence Livermore National Security, LLC and other CLIPPy
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <boost/json.hpp>
+#include <map>
+#include <string>
+
+#include "clippy/clippy.hpp"
+#include "testgraph.hpp"
+
+static const std::string method_name = "memory_usage";
+static const std::string state_name = "INTERNAL";
+
+int main(int argc, char **argv) {
+  clippy::clippy clip{method_name,
+                      "Returns the memory the graph uses, in bytes"};
+
+  clip.returns<std::map<std::string, mvmap::table_memory_usage>>(
+      "Bytes used by the key dictionary and each series of the node and edge "
+      "tables.");
+
+  // no object-state requirements in constructor
+  if (clip.parse(argc, argv)) {
+    return 0;
+  }
+
+  auto the_graph = clip.get_state<testgraph::testgraph>(state_name);
+
+  clip.to_return(the_graph.memory_usage());
+  return 0;
+}
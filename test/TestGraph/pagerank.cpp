@@ -0,0 +1,90 @@
+// Copyright 2021 Lawrence Livermore National Security, LLC and other CLIPPy
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <boost/json.hpp>
+#include <clippy/clippy.hpp>
+#include <iostream>
+#include <jsonlogic/src.hpp>
+#include <map>
+#include <optional>
+
+#include "clippy/selector.hpp"
+#include "pagerank_method.hpp"
+#include "testgraph.hpp"
+
+static const std::string method_name = "pagerank";
+static const std::string state_name = "INTERNAL";
+static const std::string sel_state_name = "selectors";
+
+int main(int argc, char **argv) {
+  clippy::clippy clip{
+      method_name, "Populates a column containing the PageRank of each node"};
+  clip.add_required<selector>(
+      "selector", "Existing selector name into which the rank will be written");
+  testgraph::add_pagerank_options(clip);
+  clip.add_required_state<testgraph::testgraph>(state_name,
+                                                "Internal container");
+  clip.add_required_state<std::map<std::string, std::string>>(
+      sel_state_name, "Internal container for pending selectors");
+
+  // no object-state requirements in constructor
+  if (clip.parse(argc, argv)) {
+    return 0;
+  }
+
+  selector sel = clip.get<selector>("selector");
+  auto options = testgraph::get_pagerank_options(clip);
+  if (!options) {
+    return 1;
+  }
+
+  if (!sel.headeq("node")) {
+    std::cerr << "Selector must be a node subselector" << std::endl;
+    return 1;
+  }
+  auto the_graph = clip.get_state<testgraph::testgraph>(state_name);
+
+  auto selectors =
+      clip.get_state<std::map<std::string, std::string>>(sel_state_name);
+  if (!selectors.contains(sel)) {
+    std::cerr << "Selector not found" << std::endl;
+    return 1;
+  }
+  auto subsel = sel.tail().value();
+  if (the_graph.has_node_series(subsel)) {
+    std::cerr << "Selector already populated" << std::endl;
+    return 1;
+  }
+
+  std::optional<testgraph::csr> weighted;
+  if (!testgraph::get_pagerank_weights(clip, the_graph, weighted)) {
+    return 1;
+  }
+
+  // the walk teleports uniformly to every node.
+  const auto &nodes = the_graph.nodemap();
+  std::vector<double> teleport(nodes.index_capacity(), 0);
+  for (testgraph::node_id i = 0; i < teleport.size(); ++i) {
+    if (nodes.has_key_at(i)) {
+      teleport[i] = 1.0 / double(nodes.size());
+    }
+  }
+
+  const auto &in =
+      weighted ? *weighted : the_graph.adjacency_index().in_edges();
+  auto result = testgraph::pagerank(in, teleport, options->damping,
+                                    options->tolerance,
+                                    options->max_iterations);
+  if (!testgraph::add_rank_series(the_graph, subsel, "PageRank",
+                                  result.rank)) {
+    return 1;
+  }
+
+  clip.set_state(state_name, the_graph);
+  clip.set_state(sel_state_name, selectors);
+  clip.update_selectors(selectors);
+  clip.to_return(testgraph::pagerank_stats(result));
+  return 0;
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <boost/json.hpp>
+#include <clippy/clippy.hpp>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "clippy/selector.hpp"
+#include "pagerank.hpp"
+#include "testgraph.hpp"
+
+// What the pagerank and personalized_pagerank methods share: their options,
+// the edge weights, and writing the ranks back. Kept apart from pagerank.hpp
+// so that the algorithm doesn't depend on clippy.
+namespace testgraph {
+
+struct pagerank_options {
+  double damping = 0.85;
+  double tolerance = 1e-6;
+  size_t max_iterations = 100;
+};
+
+// adds the options and the return value both methods have.
+inline void add_pagerank_options(clippy::clippy &clip) {
+  clip.add_optional<boost::json::object>(
+      "weight", "Numeric edge series to weight the edges by",
+      boost::json::object{});
+  clip.add_optional<double>("damping", "Probability of following an edge",
+                            0.85);
+  clip.add_optional<double>(
+      "tolerance", "Stop once the ranks move less than this in L1", 1e-6);
+  clip.add_optional<int64_t>("max_iterations",
+                             "Stop after this many iterations", 100);
+  clip.returns<boost::json::object>(
+      "Iterations run, the final L1 residual and whether it converged");
+}
+
+// returns the options, or nullopt, having said why, if they are out of
+// range.
+inline std::optional<pagerank_options> get_pagerank_options(
+    clippy::clippy &clip) {
+  auto damping = clip.get<double>("damping");
+  auto tolerance = clip.get<double>("tolerance");
+  auto max_iterations = clip.get<int64_t>("max_iterations");
+  if (damping < 0 || damping > 1 || max_iterations < 0) {
+    std::cerr << "damping must be in [0, 1] and max_iterations non-negative"
+              << std::endl;
+    return std::nullopt;
+  }
+  return pagerank_options{damping, tolerance, size_t(max_iterations)};
+}
+
+// sets weighted to the in edges weighted by the "weight" edge series, if
+// there is one. Returns false, having said why, if it isn't a numeric edge
+// series or has a negative value.
+inline bool get_pagerank_weights(clippy::clippy &clip, testgraph &g,
+                                 std::optional<csr> &weighted) {
+  if (!clip.has_argument("weight")) {
+    return true;
+  }
+  selector weight{clip.get<boost::json::object>("weight")};
+  if (!weight.headeq("edge")) {
+    std::cerr << "Weight must be an edge subselector" << std::endl;
+    return false;
+  }
+  weighted = g.weighted_in_edges(weight.tail().value());
+  if (!weighted) {
+    std::cerr << "Weight must be a numeric edge series" << std::endl;
+    return false;
+  }
+  for (node_id i = 0; i < weighted->num_rows(); ++i) {
+    for (auto w : weighted->values(i)) {
+      if (w < 0) {
+        std::cerr << "Weights must not be negative" << std::endl;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// writes each node's rank to a new node series. Returns false, having said
+// why, if the series can't be added.
+inline bool add_rank_series(testgraph &g, const std::string &subsel,
+                            const std::string &desc,
+                            const std::vector<double> &ranks) {
+  auto rank_o = g.add_node_series<double>(subsel, desc);
+  if (!rank_o) {
+    std::cerr << "Unable to manifest node series" << std::endl;
+    return false;
+  }
+  auto rank = rank_o.value();
+  const auto &nodes = g.nodemap();
+  for (node_id i = 0; i < ranks.size(); ++i) {
+    if (nodes.has_key_at(i)) {
+      rank[testgraph::node_locator(i)] = ranks[i];
+    }
+  }
+  return true;
+}
+
+inline boost::json::object pagerank_stats(const pagerank_result &result) {
+  boost::json::object stats;
+  stats["iterations"] = result.iterations;
+  stats["residual"] = result.residual;
+  stats["converged"] = result.converged;
+  return stats;
+}
+
+}  // namespace testgraph
@@ -0,0 +1,128 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace testgraph {
+
+// ranges with fewer items than this per thread are split over fewer
+// threads.
+inline constexpr size_t min_items_per_thread = size_t{1} << 14;
+
+// the number of threads to split n items over: num_threads, or one per core
+// if 0, but no more than leave each min_items_per_thread.
+inline unsigned thread_count(size_t n, unsigned num_threads = 0) {
+  if (num_threads == 0) {
+    num_threads = std::max(1U, std::thread::hardware_concurrency());
+  }
+  return unsigned(
+      std::clamp<size_t>(n / min_items_per_thread, 1, num_threads));
+}
+
+// splits [0, n) into one block per thread and calls f(t, lo, hi) for block
+// t on its own thread, the first on the calling thread. Returns once every
+// block is done.
+template <typename F>
+void parallel_blocks(size_t n, unsigned num_threads, F f) {
+  size_t block = (n + num_threads - 1) / num_threads;
+  auto run = [&f, n, block](unsigned t) {
+    size_t lo = std::min(n, t * block);
+    f(t, lo, std::min(n, lo + block));
+  };
+  std::vector<std::jthread> workers;
+  for (unsigned t = 1; t < num_threads; ++t) {
+    workers.emplace_back(run, t);
+  }
+  run(0);
+}
+
+// calls f(t, lo, hi) for chunks of [0, n) of at most chunk items, handing the
+// next chunk to whichever of num_threads threads is free first. Use this
+// rather than parallel_blocks when the cost of items varies widely.
+template <typename F>
+void parallel_chunks(size_t n, unsigned num_threads, size_t chunk, F f) {
+  std::atomic<size_t> next{0};
+  parallel_blocks(num_threads, num_threads,
+                  [&f, &next, n, chunk](unsigned t, size_t /*lo*/,
+                                        size_t /*hi*/) {
+                    for (auto lo = next.fetch_add(chunk); lo < n;
+                         lo = next.fetch_add(chunk)) {
+                      f(t, lo, std::min(n, lo + chunk));
+                    }
+                  });
+}
+
+// sorts v: blocks of it are sorted on num_threads threads, then merged
+// pairwise, in parallel, until one block remains.
+template <typename T>
+void parallel_sort(std::vector<T> &v, unsigned num_threads = 0) {
+  size_t n = v.size();
+  num_threads = thread_count(n, num_threads);
+  size_t width = (n + num_threads - 1) / num_threads;
+  parallel_blocks(n, num_threads, [&v](unsigned /*t*/, size_t lo, size_t hi) {
+    std::sort(v.begin() + lo, v.begin() + hi);
+  });
+  for (; width < n; width *= 2) {
+    size_t pairs = (n + 2 * width - 1) / (2 * width);
+    parallel_blocks(pairs, unsigned(std::min<size_t>(pairs, num_threads)),
+                    [&v, n, width](unsigned /*t*/, size_t lo, size_t hi) {
+                      for (auto p = lo; p < hi; ++p) {
+                        auto first = p * 2 * width;
+                        auto mid = std::min(n, first + width);
+                        auto last = std::min(n, first + 2 * width);
+                        std::inplace_merge(v.begin() + first, v.begin() + mid,
+                                           v.begin() + last);
+                      }
+                    });
+  }
+}
+
+// sorts v by least-significant-digit radix sort, 16 bits a pass and only as
+// many passes as the largest value needs. Each pass counts the digits of a
+// block of v per thread, then scatters the blocks in parallel, each thread
+// to the offsets its counts reserved, which keeps the sort stable.
+inline void radix_sort(std::vector<uint64_t> &v, unsigned num_threads = 0) {
+  constexpr int digit_bits = 16;
+  constexpr size_t num_digits = size_t{1} << digit_bits;
+  size_t n = v.size();
+  if (n < 2) {
+    return;
+  }
+  num_threads = thread_count(n, num_threads);
+  auto bits = std::bit_width(*std::max_element(v.begin(), v.end()));
+  std::vector<uint64_t> sorted(n);
+  std::vector<std::vector<size_t>> offsets(num_threads,
+                                           std::vector<size_t>(num_digits));
+  for (int shift = 0; shift < int(bits); shift += digit_bits) {
+    auto digit = [shift](uint64_t x) {
+      return (x >> shift) & (num_digits - 1);
+    };
+    parallel_blocks(n, num_threads, [&](unsigned t, size_t lo, size_t hi) {
+      auto &counts = offsets[t];
+      std::fill(counts.begin(), counts.end(), 0);
+      for (auto i = lo; i < hi; ++i) {
+        ++counts[digit(v[i])];
+      }
+    });
+    size_t sum = 0;
+    for (size_t d = 0; d < num_digits; ++d) {
+      for (auto &counts : offsets) {
+        sum += std::exchange(counts[d], sum);
+      }
+    }
+    parallel_blocks(n, num_threads, [&](unsigned t, size_t lo, size_t hi) {
+      auto &next = offsets[t];
+      for (auto i = lo; i < hi; ++i) {
+        sorted[next[digit(v[i])]++] = v[i];
+      }
+    });
+    v.swap(sorted);
+  }
+}
+
+}  // namespace testgraph
@@ -0,0 +1,110 @@
+// Copyright 2021 Lawrence Livermore National Security, LLC and other CLIPPy
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <boost/json.hpp>
+#include <clippy/clippy.hpp>
+#include <iostream>
+#include <jsonlogic/src.hpp>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "clippy/selector.hpp"
+#include "pagerank_method.hpp"
+#include "testgraph.hpp"
+
+static const std::string method_name = "personalized_pagerank";
+static const std::string state_name = "INTERNAL";
+static const std::string sel_state_name = "selectors";
+
+int main(int argc, char **argv) {
+  clippy::clippy clip{
+      method_name,
+      "Populates a column containing the PageRank of each node, personalized "
+      "to a set of source nodes"};
+  clip.add_required<std::vector<std::string>>(
+      "sources", "Nodes the walk teleports to, uniformly");
+  clip.add_required<selector>(
+      "selector", "Existing selector name into which the rank will be written");
+  testgraph::add_pagerank_options(clip);
+  clip.add_required_state<testgraph::testgraph>(state_name,
+                                                "Internal container");
+  clip.add_required_state<std::map<std::string, std::string>>(
+      sel_state_name, "Internal container for pending selectors");
+
+  // no object-state requirements in constructor
+  if (clip.parse(argc, argv)) {
+    return 0;
+  }
+
+  auto sources = clip.get<std::vector<std::string>>("sources");
+  selector sel = clip.get<selector>("selector");
+  auto options = testgraph::get_pagerank_options(clip);
+  if (!options) {
+    return 1;
+  }
+
+  if (!sel.headeq("node")) {
+    std::cerr << "Selector must be a node subselector" << std::endl;
+    return 1;
+  }
+  auto the_graph = clip.get_state<testgraph::testgraph>(state_name);
+
+  auto selectors =
+      clip.get_state<std::map<std::string, std::string>>(sel_state_name);
+  if (!selectors.contains(sel)) {
+    std::cerr << "Selector not found" << std::endl;
+    return 1;
+  }
+  auto subsel = sel.tail().value();
+
+  std::vector<testgraph::node_id> source_ids;
+  for (const auto &source : sources) {
+    auto id = the_graph.find_node(source);
+    if (!id) {
+      std::cerr << "Source node " << source << " not found" << std::endl;
+      return 1;
+    }
+    source_ids.push_back(*id);
+  }
+  if (source_ids.empty()) {
+    std::cerr << "At least one source node is required" << std::endl;
+    return 1;
+  }
+  if (the_graph.has_node_series(subsel)) {
+    std::cerr << "Selector already populated" << std::endl;
+    return 1;
+  }
+
+  std::optional<testgraph::csr> weighted;
+  if (!testgraph::get_pagerank_weights(clip, the_graph, weighted)) {
+    return 1;
+  }
+
+  // the walk teleports uniformly to the sources; a source listed twice is
+  // twice as likely.
+  const auto &nodes = the_graph.nodemap();
+  std::vector<double> teleport(nodes.index_capacity(), 0);
+  for (auto id : source_ids) {
+    teleport[id] += 1.0 / double(source_ids.size());
+  }
+
+  const auto &in =
+      weighted ? *weighted : the_graph.adjacency_index().in_edges();
+  auto result = testgraph::pagerank(in, teleport, options->damping,
+                                    options->tolerance,
+                                    options->max_iterations);
+  if (!testgraph::add_rank_series(the_graph, subsel, "Personalized PageRank",
+                                  result.rank)) {
+    return 1;
+  }
+
+  clip.set_state(state_name, the_graph);
+  clip.set_state(sel_state_name, selectors);
+  clip.update_selectors(selectors);
+  clip.to_return(testgraph::pagerank_stats(result));
+  return 0;
+}
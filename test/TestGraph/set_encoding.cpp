@@ -0,0 +1,71 @@
+// Copyright 2021 Lawrence Livermore National Security, LLC and other CLIPPy
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <boost/json.hpp>
+#include <iostream>
+
+#include "clippy/clippy.hpp"
+#include "clippy/selector.hpp"
+#include "testgraph.hpp"
+
+static const std::string method_name = "set_encoding";
+static const std::string graph_state_name = "INTERNAL";
+
+int main(int argc, char **argv) {
+  clippy::clippy clip{method_name,
+                      "Dictionary-encodes a series, storing each distinct "
+                      "value once, or decodes it again"};
+  clip.add_required<selector>("selector", "Existing selector to encode");
+  clip.add_optional<std::string>("encoding",
+                                 "Either \"dictionary\" or \"plain\"",
+                                 "dictionary");
+  clip.add_required_state<testgraph::testgraph>(graph_state_name,
+                                                "Internal state for the graph");
+  clip.returns_self();
+
+  if (clip.parse(argc, argv)) {
+    return 0;
+  }
+
+  auto sel = clip.get<selector>("selector");
+  auto tail_opt = sel.tail();
+  if (!tail_opt) {
+    std::cerr << "Selector must have a tail" << std::endl;
+    return 1;
+  }
+  auto subsel = tail_opt.value();
+
+  auto name = clip.get<std::string>("encoding");
+  mvmap::series_encoding encoding;
+  if (name == "dictionary") {
+    encoding = mvmap::series_encoding::dictionary;
+  } else if (name == "plain") {
+    encoding = mvmap::series_encoding::plain;
+  } else {
+    std::cerr << "Encoding must be either \"dictionary\" or \"plain\""
+              << std::endl;
+    return 1;
+  }
+
+  auto the_graph = clip.get_state<testgraph::testgraph>(graph_state_name);
+  bool encoded = false;
+  if (sel.headeq("edge")) {
+    encoded = the_graph.set_edge_encoding(subsel, encoding);
+  } else if (sel.headeq("node")) {
+    encoded = the_graph.set_node_encoding(subsel, encoding);
+  } else {
+    std::cerr << "Selector name must start with either \"edge.\" or \"node.\""
+              << std::endl;
+    return 1;
+  }
+  if (!encoded) {
+    std::cerr << "Selector " << sel << " is not populated" << std::endl;
+    return 1;
+  }
+
+  clip.set_state(graph_state_name, the_graph);
+  clip.return_self();
+  return 0;
+}
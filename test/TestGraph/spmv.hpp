@@ -0,0 +1,36 @@
+#pragma once
+#include <span>
+
+#include "adjacency.hpp"
+#include "parallel.hpp"
+
+namespace testgraph {
+
+// y = a x: y[i] is the sum over the entries (i, j) of a of their value times
+// x[j], taking the value as 1 if a is unweighted. Blocks of rows are summed
+// on num_threads threads; each row is read once and writes only y[i].
+inline void spmv(const csr &a, std::span<const double> x, std::span<double> y,
+                 unsigned num_threads = 0) {
+  size_t n = a.num_rows();
+  num_threads = thread_count(a.num_entries() + n, num_threads);
+  parallel_blocks(n, num_threads,
+                  [&a, x, y](unsigned /*t*/, size_t lo, size_t hi) {
+                    for (auto i = lo; i < hi; ++i) {
+                      auto cols = a.neighbors(i);
+                      auto vals = a.values(i);
+                      double sum = 0;
+                      if (vals.empty()) {
+                        for (auto j : cols) {
+                          sum += x[j];
+                        }
+                      } else {
+                        for (size_t k = 0; k < cols.size(); ++k) {
+                          sum += vals[k] * x[cols[k]];
+                        }
+                      }
+                      y[i] = sum;
+                    }
+                  });
+}
+
+}  // namespace testgraph
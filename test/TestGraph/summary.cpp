@@ -0,0 +1,113 @@
+// Copyright 2021 Lawrence Livermore National Security, LLC and other CLIPPy
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <boost/json.hpp>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <type_traits>
+#include <variant>
+
+#include "clippy/clippy.hpp"
+#include "clippy/selector.hpp"
+#include "testgraph.hpp"
+
+static const std::string method_name = "summary";
+static const std::string graph_state_name = "INTERNAL";
+
+namespace {
+
+using summary_t = std::map<std::string, boost::json::value>;
+
+// summarizes a series, maintaining its statistics from then on so that
+// later summaries and extrema don't have to scan it. Keys are converted by
+// name.
+template <typename Series, typename KeyName>
+summary_t summarize(Series ser, KeyName name) {
+  ser.track_stats();
+  const auto &stats = *ser.stats(true);
+  summary_t summary{{"count", stats.count()},
+                    {"null_count", ser.null_count()},
+                    {"distinct", std::llround(stats.distinct())}};
+  if constexpr (!std::is_same_v<decltype(stats.sum()), std::monostate>) {
+    summary["sum"] = stats.sum();
+  }
+  auto [min, max] = ser.extrema();
+  if (min) {
+    summary["min"] = boost::json::value_from(
+        std::make_pair(name(std::get<1>(*min)), std::get<0>(*min)));
+  }
+  if (max) {
+    summary["max"] = boost::json::value_from(
+        std::make_pair(name(std::get<1>(*max)), std::get<0>(*max)));
+  }
+  return summary;
+}
+
+// summarizes the series if it holds values of type V.
+template <typename V>
+std::optional<summary_t> summarize_as(testgraph::testgraph &g, bool is_edge,
+                                      const std::string &sel) {
+  if (is_edge) {
+    auto ser = g.get_edge_series<V>(sel);
+    auto name = [&g](const auto &key) { return g.edge_name(key); };
+    return ser ? std::optional(summarize(*ser, name)) : std::nullopt;
+  }
+  auto ser = g.get_node_series<V>(sel);
+  return ser ? std::optional(summarize(*ser, std::identity{})) : std::nullopt;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  clippy::clippy clip{method_name,
+                      "Returns the count, number of missing values, "
+                      "approximate number of distinct values, sum, and "
+                      "minimum and maximum of a series"};
+  clip.add_required<selector>("selector", "Existing selector to summarize");
+  clip.add_required_state<testgraph::testgraph>(graph_state_name,
+                                                "Internal state for the graph");
+  clip.returns<summary_t>("summary statistics of the series");
+
+  if (clip.parse(argc, argv)) {
+    return 0;
+  }
+
+  auto sel = clip.get<selector>("selector");
+  bool is_edge = sel.headeq("edge");
+  if (!is_edge && !sel.headeq("node")) {
+    std::cerr << "Selector name must start with either \"edge.\" or \"node.\""
+              << std::endl;
+    return 1;
+  }
+  auto tail_opt = sel.tail();
+  if (!tail_opt) {
+    std::cerr << "Selector must have a tail" << std::endl;
+    return 1;
+  }
+  auto subsel = tail_opt.value();
+
+  auto the_graph = clip.get_state<testgraph::testgraph>(graph_state_name);
+  auto summary = summarize_as<int64_t>(the_graph, is_edge, subsel);
+  if (!summary) {
+    summary = summarize_as<double>(the_graph, is_edge, subsel);
+  }
+  if (!summary) {
+    summary = summarize_as<bool>(the_graph, is_edge, subsel);
+  }
+  if (!summary) {
+    summary = summarize_as<std::string>(the_graph, is_edge, subsel);
+  }
+  if (!summary) {
+    std::cerr << "Selector " << sel << " is not populated" << std::endl;
+    return 1;
+  }
+
+  clip.set_state(graph_state_name, the_graph);
+  clip.to_return(*summary);
+  return 0;
+}
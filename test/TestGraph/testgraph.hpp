@@ -1,12 +1,24 @@
 #pragma once
+#include <algorithm>
+#include <bit>
 #include <cstdint>
+#include <fstream>
+#include <limits>
 #include <map>
+#include <memory_resource>
+#include <optional>
 #include <ranges>
+#include <span>
+#include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "../include/mvmap.hpp"
+#include "adjacency.hpp"
+#include "components.hpp"
+#include "edge_list.hpp"
+#include "parallel.hpp"
 #include "boost/json.hpp"
 
 namespace testgraph {
@@ -14,6 +26,13 @@ namespace testgraph {
 using node_t = std::string;
 using edge_t = std::pair<node_t, node_t>;
 
+// Node names are interned: a node's id is its index in the node table, and
+// the edge table is keyed by the ids of each edge's endpoints. Algorithms
+// work on ids, and names are looked up only at the API boundary. Ids are
+// stable because the node table is never compacted.
+using node_id = mvmap::index;
+using edge_key = std::pair<node_id, node_id>;
+
 template <typename T>
 using sparsevec = std::map<uint64_t, T>;
 
@@ -21,7 +40,8 @@ enum series_type { ser_bool, ser_int64, ser_double, ser_string, ser_invalid };
 
 using variants = std::variant<bool, double, int64_t, std::string>;
 class testgraph {
-  using edge_mvmap = mvmap::mvmap<edge_t, bool, int64_t, double, std::string>;
+  using edge_mvmap =
+      mvmap::mvmap<edge_key, bool, int64_t, double, std::string>;
   using node_mvmap = mvmap::mvmap<node_t, bool, int64_t, double, std::string>;
   template <typename T>
   using edge_series_proxy = edge_mvmap::series_proxy<T>;
@@ -30,16 +50,136 @@ class testgraph {
   node_mvmap node_table;
   edge_mvmap edge_table;
 
+  // built on first use, and rebuilt once the keys of either table change.
+  mutable std::optional<adjacency> adj;
+  // maintained by the methods that add nodes and edges while tracking is
+  // on; see track_components.
+  mutable std::optional<incremental_components> comps;
+
+  [[nodiscard]] bool components_current() const {
+    return comps && comps->is_current(node_table, edge_table);
+  }
+
+  // sorts edge keys. When the two ids fit in one word together they are
+  // packed and radix sorted, which is several times faster than comparing
+  // pairs.
+  static void sort_edge_keys(std::vector<edge_key> &keys,
+                             unsigned num_threads) {
+    node_id max_src = 0;
+    node_id max_dst = 0;
+    for (const auto &[src, dst] : keys) {
+      max_src = std::max(max_src, src);
+      max_dst = std::max(max_dst, dst);
+    }
+    auto dst_bits = std::bit_width(max_dst);
+    if (std::bit_width(max_src) + dst_bits >= 64) {
+      parallel_sort(keys, num_threads);
+      return;
+    }
+    std::vector<uint64_t> packed(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+      packed[i] = keys[i].first << dst_bits | keys[i].second;
+    }
+    radix_sort(packed, num_threads);
+    auto dst_mask = (uint64_t{1} << dst_bits) - 1;
+    for (size_t i = 0; i < keys.size(); ++i) {
+      keys[i] = {packed[i] >> dst_bits, packed[i] & dst_mask};
+    }
+  }
+
+  // the keys of num_edges edges between named nodes, adding the nodes that
+  // aren't in the graph yet; name(j), a node_t or a std::string_view, is
+  // the source of edge j / 2 if j is even, else its destination. Names are
+  // interned in batches, and a node_t is built only for a new one; on more
+  // than one thread they are first looked up in parallel, so only the new
+  // ones are left to intern.
+  template <typename Name>
+  std::vector<edge_key> intern_edges(size_t num_edges, Name name,
+                                     unsigned num_threads) {
+    std::vector<edge_key> keys(num_edges);
+    auto id = [&keys](size_t j) -> node_id & {
+      return j % 2 == 0 ? keys[j / 2].first : keys[j / 2].second;
+    };
+
+    num_threads = thread_count(num_edges, num_threads);
+    if (num_threads == 1) {
+      auto ids = node_table.insert_keys_by(2 * num_edges, name);
+      for (size_t j = 0; j < ids.size(); ++j) {
+        id(j) = ids[j];
+      }
+      return keys;
+    }
+
+    constexpr auto missing = std::numeric_limits<node_id>::max();
+    parallel_blocks(2 * num_edges, num_threads,
+                    [&](unsigned /*t*/, size_t lo, size_t hi) {
+                      for (auto j = lo; j < hi; ++j) {
+                        id(j) = node_table.find_index(name(j)).value_or(
+                            missing);
+                      }
+                    });
+    std::vector<size_t> unseen;
+    for (size_t j = 0; j < 2 * num_edges; ++j) {
+      if (id(j) == missing) {
+        unseen.push_back(j);
+      }
+    }
+    // the unseen names bound the new nodes, so the table grows at most once.
+    node_table.reserve_keys(unseen.size());
+    auto ids = node_table.insert_keys_by(
+        unseen.size(), [&](size_t k) { return name(unseen[k]); });
+    for (size_t k = 0; k < unseen.size(); ++k) {
+      id(unseen[k]) = ids[k];
+    }
+    return keys;
+  }
+
+  // adds the edges between nodes already in the graph, by id. The keys are
+  // sorted and deduplicated in parallel, those already in the graph dropped,
+  // and the rest added in one batch, and united in the tracked components
+  // if they were current before the nodes were added. Returns the number of
+  // edges added.
+  size_t insert_edge_keys(std::vector<edge_key> keys, bool current,
+                          unsigned num_threads) {
+    sort_edge_keys(keys, num_threads);
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    if (edge_table.size() > 0) {
+      std::vector<uint8_t> is_new(keys.size());
+      parallel_blocks(keys.size(), thread_count(keys.size(), num_threads),
+                      [this, &keys, &is_new](unsigned /*t*/, size_t lo,
+                                             size_t hi) {
+                        for (auto i = lo; i < hi; ++i) {
+                          is_new[i] = edge_table.find_index(keys[i]) ? 0 : 1;
+                        }
+                      });
+      size_t kept = 0;
+      for (size_t i = 0; i < keys.size(); ++i) {
+        if (is_new[i] != 0) {
+          keys[kept++] = keys[i];
+        }
+      }
+      keys.resize(kept);
+    }
+    auto added = edge_table.insert_keys(keys);
+    if (current) {
+      for (const auto &[src, dst] : keys) {
+        comps->unite(src, dst);
+      }
+      comps->stamp(node_table, edge_table);
+    }
+    return added;
+  }
+
  public:
-  const mvmap::mvmap<node_t, bool, int64_t, double, std::string> &nodemap()
-      const {
+  const node_mvmap &nodemap() const {
     return node_table;
   }
+  node_mvmap &nodemap() { return node_table; }
 
-  const mvmap::mvmap<edge_t, bool, int64_t, double, std::string> &edgemap()
-      const {
+  const edge_mvmap &edgemap() const {
     return edge_table;
   }
+  edge_mvmap &edgemap() { return edge_table; }
   static inline bool is_edge_selector(const std::string &sel) {
     return sel.starts_with("edge.");
   }
@@ -56,6 +196,9 @@ class testgraph {
                          boost::json::value &v, testgraph const &g) {
     v = {{"node_table", boost::json::value_from(g.node_table)},
          {"edge_table", boost::json::value_from(g.edge_table)}};
+    if (g.comps) {
+      v.as_object()["components"] = boost::json::value_from(*g.comps);
+    }
   }
 
   friend testgraph tag_invoke(boost::json::value_to_tag<testgraph> /*unused*/,
@@ -63,11 +206,78 @@ class testgraph {
     const auto &obj = v.as_object();
     auto nt = boost::json::value_to<node_mvmap>(obj.at("node_table"));
     auto et = boost::json::value_to<edge_mvmap>(obj.at("edge_table"));
-    return {nt, et};
+    testgraph g{nt, et};
+    if (const auto *c = obj.if_contains("components")) {
+      g.comps = boost::json::value_to<incremental_components>(*c);
+    }
+    return g;
+  }
+  // the binary format is the node table followed by the edge table, each
+  // in mvmap's binary format, and then the tracked components: a u64 that
+  // is 0 if they aren't tracked, and otherwise 1 plus the number of labels
+  // that follow it. Only current components are stored with their labels;
+  // stale ones are recomputed on next use, as they would have been.
+  void write_binary(std::ostream &os) const {
+    mvmap::binary::writer w(os);
+    node_table.write_binary(w);
+    edge_table.write_binary(w);
+    std::vector<node_id> labels;
+    if (components_current()) {
+      labels = comps->labels();
+    }
+    w.scalar(uint64_t(comps ? labels.size() + 1 : 0));
+    w.array(labels);
+    w.flush();
+  }
+
+  void save_binary(const std::string &path) const {
+    std::ofstream os(path, std::ios::binary | std::ios::trunc);
+    write_binary(os);
+    if (!os) {
+      throw std::runtime_error("cannot write " + path);
+    }
   }
+
+  static testgraph read_binary(std::span<const std::byte> bytes) {
+    mvmap::binary::reader r(bytes);
+    auto nt = node_mvmap::read_binary(r);
+    auto et = edge_mvmap::read_binary(r);
+    testgraph g{std::move(nt), std::move(et)};
+    // files written before the components were stored end here.
+    auto n = r.at_end() ? 0 : r.scalar<uint64_t>();
+    if (n == 1) {
+      g.comps.emplace();
+    } else if (n > 1) {
+      auto labels = r.array<node_id>(n - 1);
+      if (labels.size() > g.node_table.index_capacity() ||
+          std::ranges::any_of(labels, [&labels](node_id l) {
+            return l >= labels.size();
+          })) {
+        throw std::runtime_error("corrupt graph components");
+      }
+      g.comps.emplace(labels);
+      g.comps->stamp(g.node_table, g.edge_table);
+    }
+    return g;
+  }
+
+  static testgraph load_binary(const std::string &path) {
+    mvmap::binary::mapped_file file(path);
+    return read_binary(file.bytes());
+  }
+
   testgraph() = default;
   testgraph(node_mvmap nt, edge_mvmap et)
       : node_table(std::move(nt)), edge_table(std::move(et)) {};
+  // both tables allocate their series from mr; see mvmap::mvmap.
+  explicit testgraph(std::pmr::memory_resource *mr)
+      : node_table(mr), edge_table(mr) {}
+
+  // empties the graph without tearing it down; see mvmap::forget.
+  void forget() {
+    node_table.forget();
+    edge_table.forget();
+  }
 
   // this function requires that the "edge." prefix be removed from the name.
   template <typename T>
@@ -121,11 +331,43 @@ class testgraph {
     return node_table.get_series<T>(sel);
   }
 
+  // these functions require that the "edge."/"node." prefix be removed.
+  bool add_edge_index(const std::string &sel) {
+    return edge_table.add_index(sel);
+  }
+  bool add_node_index(const std::string &sel) {
+    return node_table.add_index(sel);
+  }
+  bool set_edge_encoding(const std::string &sel,
+                         mvmap::series_encoding encoding) {
+    return edge_table.set_series_encoding(sel, encoding);
+  }
+  bool set_node_encoding(const std::string &sel,
+                         mvmap::series_encoding encoding) {
+    return node_table.set_series_encoding(sel, encoding);
+  }
+
+  // the memory each table uses, keyed like the tables in the JSON format;
+  // see mvmap::memory_usage.
+  [[nodiscard]] std::map<std::string, mvmap::table_memory_usage> memory_usage()
+      const {
+    return {{"node_table", node_table.memory_usage()},
+            {"edge_table", edge_table.memory_usage()}};
+  }
+
   [[nodiscard]] size_t nv() const { return node_table.size(); }
   [[nodiscard]] size_t ne() const { return edge_table.size(); }
 
+  // F takes the (src, dst) names of an edge and its locator.
   template <typename F>
   void for_all_edges(F f) {
+    edge_table.for_all([this, &f](const edge_key &key, mvmap::locator loc) {
+      f(edge_name(key), loc);
+    });
+  }
+  // F takes the (src, dst) ids of an edge and its locator.
+  template <typename F>
+  void for_all_edge_keys(F f) {
     edge_table.for_all(f);
   }
   template <typename F>
@@ -134,25 +376,192 @@ class testgraph {
   }
 
   [[nodiscard]] std::vector<edge_t> edges() const {
-    auto kv = edge_table.keys();
-    return {kv.begin(), kv.end()};
+    std::vector<edge_t> names;
+    names.reserve(edge_table.size());
+    for (const auto &key : edge_table.keys()) {
+      names.push_back(edge_name(key));
+    }
+    return names;
   }
   [[nodiscard]] std::vector<node_t> nodes() const {
     auto kv = node_table.keys();
     return {kv.begin(), kv.end()};
   }
 
-  bool add_node(const node_t &node) { return node_table.add_key(node); };
+  bool add_node(const node_t &node) {
+    auto current = components_current();
+    bool added = node_table.add_key(node);
+    if (current) {
+      comps->stamp(node_table, edge_table);
+    }
+    return added;
+  };
   bool add_edge(const node_t &src, const node_t &dst) {
-    node_table.add_key(src);
-    node_table.add_key(dst);
-    return edge_table.add_key({src, dst});
+    auto current = components_current();
+    auto s = node_table.insert_key(src).first;
+    auto d = node_table.insert_key(dst).first;
+    bool added = edge_table.add_key({s, d});
+    if (current) {
+      comps->unite(s, d);
+      comps->stamp(node_table, edge_table);
+    }
+    return added;
+  }
+
+  // adds the edges between named nodes, and the nodes that aren't in the
+  // graph yet; see intern_edges and add_edge_keys. Returns the number of
+  // edges added.
+  size_t add_edges(std::span<const edge_t> edges, unsigned num_threads = 0) {
+    auto current = components_current();
+    auto keys = intern_edges(
+        edges.size(),
+        [edges](size_t j) -> const node_t & {
+          return j % 2 == 0 ? edges[j / 2].first : edges[j / 2].second;
+        },
+        num_threads);
+    return insert_edge_keys(std::move(keys), current, num_threads);
+  }
+
+  // adds the edges of an edge list, as add_edges does. If weight names an
+  // edge series (without its "edge." prefix), the list's weights are
+  // written to it, adding it as a double series if need be; a repeated edge
+  // keeps its last weight. Throws std::invalid_argument if the series holds
+  // another type.
+  size_t add_edges(const edge_list &list,
+                   const std::optional<std::string> &weight = std::nullopt,
+                   unsigned num_threads = 0) {
+    auto double_series = [this](const std::string &name) {
+      return has_edge_series(name) ? get_edge_series<double>(name)
+                                   : add_edge_series<double>(name);
+    };
+    auto weights = weight ? double_series(*weight) : std::nullopt;
+    if (weight && !weights) {
+      throw std::invalid_argument("edge series " + *weight +
+                                  " does not hold doubles");
+    }
+    auto current = components_current();
+    auto keys = intern_edges(
+        list.size(),
+        [&list](size_t j) { return list.names[j]; }, num_threads);
+    if (!weights) {
+      return insert_edge_keys(std::move(keys), current, num_threads);
+    }
+    auto added = insert_edge_keys(keys, current, num_threads);
+    // the series is rebuilt in one pass rather than written edge by edge.
+    std::vector<mvmap::index> rows(keys.size());
+    parallel_blocks(keys.size(), thread_count(keys.size(), num_threads),
+                    [this, &keys, &rows](unsigned /*t*/, size_t lo, size_t hi) {
+                      for (auto i = lo; i < hi; ++i) {
+                        rows[i] = *edge_table.find_index(keys[i]);
+                      }
+                    });
+    std::vector<double> dense(edge_table.index_capacity());
+    std::vector<uint64_t> present((dense.size() + 63) / 64);
+    auto set = [&dense, &present](mvmap::index i, double w) {
+      dense[i] = w;
+      present[i / 64] |= uint64_t{1} << (i % 64);
+    };
+    weights->for_all([&set](const edge_key & /*key*/, auto loc, double w) {
+      set(edge_mvmap::index_of(loc), w);
+    });
+    for (size_t i = 0; i < rows.size() && i < list.weights.size(); ++i) {
+      set(rows[i], list.weights[i]);
+    }
+    size_t num_vals = 0;
+    for (auto bits : present) {
+      num_vals += std::popcount(bits);
+    }
+    std::vector<double> vals;
+    vals.reserve(num_vals);
+    for (size_t w = 0; w < present.size(); ++w) {
+      for (auto bits = present[w]; bits != 0; bits &= bits - 1) {
+        vals.push_back(dense[w * 64 + std::countr_zero(bits)]);
+      }
+    }
+    weights->assign(present, std::move(vals));
+    return added;
+  }
+
+  // adds the edges between nodes already in the graph, by id; see
+  // insert_edge_keys. Returns the number of edges added.
+  size_t add_edge_keys(std::vector<edge_key> keys, unsigned num_threads = 0) {
+    return insert_edge_keys(std::move(keys), components_current(),
+                            num_threads);
+  }
+
+  // returns the id of a node, adding the node if it isn't in the graph.
+  node_id intern(const node_t &node) {
+    auto current = components_current();
+    auto id = node_table.insert_key(node).first;
+    if (current) {
+      comps->stamp(node_table, edge_table);
+    }
+    return id;
+  }
+
+  // keeps the components up to date as nodes and edges are added, so
+  // component_labels() need not recompute them; they are computed once when
+  // tracking starts. Nothing else updates them: after any other change to
+  // the keys, such as removing an edge, they are recomputed on next use.
+  void track_components(bool on = true, unsigned num_threads = 0) {
+    if (!on) {
+      comps.reset();
+    } else if (!comps) {
+      comps.emplace(
+          connected_components(adjacency_index().out_edges(), num_threads));
+      comps->stamp(node_table, edge_table);
+    }
+  }
+  [[nodiscard]] bool tracks_components() const { return comps.has_value(); }
+
+  // each node id's component, labeled by the smallest id in it. From the
+  // tracked components if they are current, and otherwise computed from
+  // the adjacency (which brings tracked components up to date).
+  [[nodiscard]] std::vector<node_id> component_labels(
+      unsigned num_threads = 0) const {
+    if (components_current()) {
+      return comps->labels();
+    }
+    auto labels =
+        connected_components(adjacency_index().out_edges(), num_threads);
+    if (comps) {
+      comps.emplace(labels);
+      comps->stamp(node_table, edge_table);
+    }
+    return labels;
+  }
+
+  [[nodiscard]] std::optional<node_id> find_node(const node_t &node) const {
+    return node_table.find_index(node);
+  }
+  [[nodiscard]] std::optional<edge_key> find_edge(const node_t &src,
+                                                  const node_t &dst) const {
+    auto s = find_node(src);
+    auto d = find_node(dst);
+    if (!s || !d || !edge_table.find_index({*s, *d})) {
+      return std::nullopt;
+    }
+    return edge_key{*s, *d};
+  }
+
+  // these assume the ids are those of nodes in the graph.
+  [[nodiscard]] const node_t &node_name(node_id id) const {
+    return node_table.key_at(id);
+  }
+  [[nodiscard]] edge_t edge_name(const edge_key &key) const {
+    return {node_name(key.first), node_name(key.second)};
+  }
+  // the locator of a node in the node series.
+  [[nodiscard]] static mvmap::locator node_locator(node_id id) {
+    return node_mvmap::locator_at(id);
   }
 
   bool has_node(const node_t &node) { return node_table.contains(node); };
-  bool has_edge(const edge_t &edge) { return edge_table.contains(edge); };
+  bool has_edge(const edge_t &edge) {
+    return has_edge(edge.first, edge.second);
+  };
   bool has_edge(const node_t &src, const node_t &dst) {
-    return edge_table.contains({src, dst});
+    return find_edge(src, dst).has_value();
   };
 
   // strips the head off the std::string and passes the tail to the appropriate
@@ -201,36 +610,79 @@ class testgraph {
     return edge_table.has_series<T>(sel);
   }
 
-  [[nodiscard]] std::vector<node_t> out_neighbors(const node_t &node) const {
-    std::vector<node_t> neighbors;
-    for (const auto &[src, dst] : edge_table.keys()) {
-      if (src == node) {
-        neighbors.emplace_back(dst);
-      }
+  // the CSR adjacency of the graph over node table indices; see adjacency.
+  [[nodiscard]] const adjacency &adjacency_index() const {
+    if (!adj || !adj->is_current(node_table, edge_table)) {
+      adj.emplace(node_table, edge_table);
+    }
+    return *adj;
+  }
+
+  // the transpose of the adjacency, weighted by the numeric edge series sel
+  // (without its "edge." prefix). Edges without a value are left out.
+  // Returns nullopt if there is no such series.
+  std::optional<csr> weighted_in_edges(const std::string &sel) {
+    std::vector<edge_key> pairs;
+    std::vector<double> weights;
+    auto collect = [this, &pairs, &weights](auto &ser) {
+      ser.for_all([this, &pairs, &weights](const edge_key &key,
+                                           mvmap::locator /*loc*/,
+                                           const auto &w) {
+        if (node_table.has_key_at(key.first) &&
+            node_table.has_key_at(key.second)) {
+          pairs.emplace_back(key.second, key.first);
+          weights.push_back(double(w));
+        }
+      });
+    };
+    if (auto ser = get_edge_series<double>(sel)) {
+      collect(*ser);
+    } else if (auto ser = get_edge_series<int64_t>(sel)) {
+      collect(*ser);
+    } else {
+      return std::nullopt;
     }
-    return neighbors;
+    return csr(node_table.index_capacity(), pairs, weights);
+  }
+
+  [[nodiscard]] std::vector<node_t> out_neighbors(const node_t &node) const {
+    return node_names(adjacency_index().out_neighbors(node_index(node)));
   }
 
   [[nodiscard]] std::vector<node_t> in_neighbors(const node_t &node) const {
-    std::vector<node_t> neighbors;
-    for (const auto &[src, dst] : edge_table.keys()) {
-      if (dst == node) {
-        neighbors.emplace_back(src);
-      }
-    }
-    return neighbors;
+    return node_names(adjacency_index().in_neighbors(node_index(node)));
   }
 
   [[nodiscard]] size_t in_degree(const node_t &node) const {
-    return in_neighbors(node).size();
+    return adjacency_index().in_degree(node_index(node));
   }
   [[nodiscard]] size_t out_degree(const node_t &node) const {
-    return out_neighbors(node).size();
+    return adjacency_index().out_degree(node_index(node));
+  }
+  // the number of edges incident to node, counting a self-loop once.
+  [[nodiscard]] size_t degree(const node_t &node) const {
+    return adjacency_index().degree(node_index(node));
+  }
+
+  // the id of a node, or an id past every node if it isn't in the graph.
+  [[nodiscard]] node_id node_index(const node_t &node) const {
+    return find_node(node).value_or(std::numeric_limits<node_id>::max());
+  }
+
+  [[nodiscard]] std::vector<node_t> node_names(
+      std::span<const node_id> ids) const {
+    std::vector<node_t> names;
+    names.reserve(ids.size());
+    for (auto id : ids) {
+      names.push_back(node_name(id));
+    }
+    return names;
   }
 
   std::string str_edge_col(const std::string &col) {
     std::vector<std::string> cols{col};
-    return edge_table.str_cols(cols);
+    return edge_table.str_cols(
+        cols, [this](const edge_key &key) { return edge_name(key); });
   }
 
   std::string str_node_col(const std::string &col) {
@@ -3,11 +3,17 @@
 // #include <boost/json/serialize_options.hpp>
 #include <cassert>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <set>
+#include <span>
+#include <sstream>
 #include <string>
+#include <vector>
 
 using mymap_t = mvmap::mvmap<std::string, bool, double, int64_t, std::string>;
-int main() {
 
+void test_series() {
   mymap_t m{};
 
   m.add_series<double>("weight");
@@ -15,7 +21,7 @@ int main() {
   m.add_series<std::string>("name");
   std::cout << "added series name\n";
 
-  auto hmap = m.get_or_create_series<double>("age");
+  auto hmap = m.add_series<double>("age").value();
   std::cout << "created hmap\n";
 
   hmap["seth"] = 5;
@@ -34,7 +40,7 @@ int main() {
   auto n = boost::json::value_to<mymap_t>(jv);
 
   std::cout << "created n\n";
-  auto hmap2 = n.get_or_create_series<double>("age");
+  auto hmap2 = n.get_series<double>("age").value();
   std::cout << "created hmap2\n";
   assert(hmap2["seth"] == 5);
   assert(hmap2["roger"] == 8);
@@ -69,3 +75,442 @@ int main() {
   std::cout << "sum of ages = " << age_sum << "\n";
   assert(age_sum == 8);
 }
+
+// checks that a series holds exactly the values in expected.
+template <typename Proxy, typename V>
+void check_values(const Proxy &ser, const std::map<std::string, V> &expected) {
+  assert(ser.size() == expected.size());
+  for (const auto &[k, v] : expected) {
+    assert(ser.at(k) == v);
+  }
+  ser.for_all([&expected](const auto &k, auto, const auto &v) {
+    assert(expected.at(k) == v);
+  });
+}
+
+// an automatic series goes dense once half the cells up to its largest
+// index hold a value, and back to sparse below an eighth; its values
+// survive every switch.
+void test_layouts() {
+  mymap_t m{};
+  auto ser = m.add_series<int64_t>("auto").value();
+  std::map<std::string, int64_t> expected;
+  auto put = [&ser, &expected](int i) {
+    ser["k" + std::to_string(i)] = i * 10;
+    expected["k" + std::to_string(i)] = i * 10;
+  };
+
+  for (int i = 0; i < 4; ++i) {
+    put(i);
+  }
+  assert(m.series_is_dense("auto"));
+  check_values(ser, expected);
+
+  // a far write makes the series mostly empty, so it goes sparse.
+  for (int i = 4; i < 100; ++i) {
+    m.add_key("k" + std::to_string(i));
+  }
+  put(99);
+  assert(!m.series_is_dense("auto"));
+  check_values(ser, expected);
+
+  // filling it in makes it dense again.
+  for (int i = 4; i < 50; ++i) {
+    put(i);
+  }
+  assert(m.series_is_dense("auto"));
+  check_values(ser, expected);
+
+  // erasing down to fewer than an eighth of the cells makes it sparse.
+  for (int i = 0; i < 50; ++i) {
+    if (i % 10 != 0) {
+      ser.erase("k" + std::to_string(i));
+      expected.erase("k" + std::to_string(i));
+    }
+  }
+  assert(!m.series_is_dense("auto"));
+  check_values(ser, expected);
+
+  // a fixed layout doesn't switch, and switching it keeps the values.
+  m.set_series_layout("auto", mvmap::series_layout::dense);
+  assert(m.series_is_dense("auto"));
+  check_values(ser, expected);
+  put(3);
+  assert(m.series_is_dense("auto"));
+  m.set_series_layout("auto", mvmap::series_layout::sparse);
+  for (const auto &[k, v] : expected) {
+    ser[k] = v;
+  }
+  assert(!m.series_is_dense("auto"));
+  check_values(ser, expected);
+  // back to automatic, 7 of 101 cells is sparse.
+  m.set_series_layout("auto", mvmap::series_layout::automatic);
+  assert(!m.series_is_dense("auto"));
+  check_values(ser, expected);
+}
+
+// after erasing keys one at a time (backward-shift deletion) or in bulk (an
+// in-place rehash), every remaining key must still be found at its index.
+void test_key_dictionary() {
+  mvmap::key_dictionary<std::string> dict;
+  std::map<std::string, mvmap::index> expected;
+  auto key = [](int i) { return "k" + std::to_string(i); };
+  auto check = [&dict, &expected]() {
+    assert(dict.size() == expected.size());
+    for (const auto &[k, i] : expected) {
+      assert(dict.find(k) == i && dict.find(std::string_view(k)) == i);
+      assert(dict.has_index(i) && dict.key_at(i) == k);
+    }
+    dict.for_all([&expected](const std::string &k, mvmap::index i) {
+      assert(expected.at(k) == i);
+    });
+  };
+  auto erase = [&dict, &expected](const std::string &k) {
+    dict.erase(expected.at(k));
+    expected.erase(k);
+    assert(!dict.contains(k));
+  };
+
+  // 12 keys fill the smallest table to 3/4, so probe runs are long and
+  // wrap around its end.
+  for (int i = 0; i < 12; ++i) {
+    expected[key(i)] = dict.insert(key(i)).first;
+  }
+  check();
+  for (int i = 0; i < 12; i += 2) {
+    erase(key(i));
+    check();
+  }
+  // erased keys come back at new indices.
+  for (int i = 0; i < 12; i += 2) {
+    auto [idx, inserted] = dict.insert(key(i));
+    assert(inserted && idx >= 12);
+    expected[key(i)] = idx;
+  }
+  check();
+
+  for (int i = 12; i < 5000; ++i) {
+    expected[key(i)] = dict.insert(key(i)).first;
+  }
+  mvmap::selection rows(dict.capacity());
+  for (int i = 0; i < 5000; i += 3) {
+    rows.insert(expected.at(key(i)));
+    expected.erase(key(i));
+  }
+  dict.erase(rows);
+  check();
+  for (int i = 0; i < 5000; ++i) {
+    if (i % 7 == 0 && expected.contains(key(i))) {
+      erase(key(i));
+    }
+  }
+  check();
+  for (int i = 0; i < 5000; i += 3) {
+    expected[key(i)] = dict.insert(key(i)).first;
+  }
+  check();
+
+  // a batch of string_views copies only the new keys into the dictionary.
+  std::vector<std::string> more = {key(1), "new", key(3), "new"};
+  std::vector<mvmap::index> out(more.size());
+  auto added = dict.insert_batch(
+      more.size(), [&more](size_t j) { return std::string_view(more[j]); },
+      out);
+  assert(added == 1 && out[1] == out[3] && out[0] == expected.at(key(1)));
+  expected["new"] = out[1];
+  check();
+}
+
+// remove_if with renumber closes the gaps the removed keys leave: the
+// remaining keys keep their order, and every series, its statistics and its
+// index follow them to their new indices.
+void test_remove_renumber() {
+  mymap_t m{};
+  auto num = m.add_series<int64_t>("num").value();
+  auto name = m.add_series<std::string>("name").value();
+  auto half =
+      m.add_series<double>("half", "", mvmap::series_layout::sparse).value();
+  auto key = [](int i) { return "k" + std::to_string(i); };
+  auto num_of = [](const std::string &k) { return std::stoi(k.substr(1)); };
+  for (int i = 0; i < 200; ++i) {
+    num[key(i)] = i;
+    name[key(i)] = "n" + std::to_string(i % 5);
+    if (i % 2 == 0) {
+      half[key(i)] = i / 2.0;
+    }
+  }
+  m.set_series_encoding("name", mvmap::series_encoding::dictionary);
+  m.track_series_stats("num");
+  m.add_index("num");
+  assert(m.index_count("num", mvmap::cmp_op::lt, int64_t{10}) == 10);
+
+  // checks the map holds exactly the keys i < 200 for which keep(i) is true,
+  // at dense indices in key order.
+  auto check = [&](auto keep) {
+    size_t n = 0;
+    int64_t sum = 0;
+    size_t halves = 0;
+    std::vector<int> small;
+    for (int i = 0; i < 200; ++i) {
+      if (!keep(i)) {
+        assert(!m.contains(key(i)) && !num.at(key(i)));
+        continue;
+      }
+      ++n;
+      sum += i;
+      halves += i % 2 == 0 ? 1 : 0;
+      if (i < 10) {
+        small.push_back(i);
+      }
+      assert(num.at(key(i)) == i);
+      assert(name.at(key(i))->get() == "n" + std::to_string(i % 5));
+      assert(half.at(key(i)) ==
+             (i % 2 == 0 ? std::optional(i / 2.0) : std::nullopt));
+    }
+    assert(m.size() == n && m.index_capacity() == n);
+    assert(half.size() == halves && name.dictionary() != nullptr);
+
+    mvmap::index next = 0;
+    int prev = -1;
+    m.for_all([&](const std::string &k, auto) {
+      assert(num_of(k) > prev && m.find_index(k) == next++);
+      prev = num_of(k);
+    });
+
+    const auto *st = num.stats();
+    assert(st != nullptr && st->count() == n && st->sum() == sum);
+    auto [lo, hi] = num.extrema();
+    assert(num.at(std::get<2>(*lo)) == num_of(std::get<1>(*lo)));
+    assert(num.at(std::get<2>(*hi)) == num_of(std::get<1>(*hi)));
+    assert(std::get<0>(*lo) == small.front() && std::get<0>(*hi) == prev);
+
+    auto sel = m.index_select("num", mvmap::cmp_op::lt, int64_t{10});
+    assert(sel && sel->count() == small.size());
+    for (auto i : sel->indices()) {
+      assert(num.at(m.key_at(i)) < 10);
+    }
+  };
+
+  m.remove_if([&](const std::string &k, auto) { return num_of(k) % 3 == 0; },
+              true);
+  check([](int i) { return i % 3 != 0; });
+
+  // keys removed without renumbering leave gaps the index and the
+  // statistics are built over; a later renumber must move them too.
+  m.remove_if([&](const std::string &k, auto) { return num_of(k) % 5 == 0; });
+  assert(m.index_count("num", mvmap::cmp_op::lt, int64_t{10}) == 5);
+  assert(num.extrema().second && m.size() < m.index_capacity());
+  m.remove_if([](const std::string &, auto) { return false; }, true);
+  check([](int i) { return i % 3 != 0 && i % 5 != 0; });
+}
+
+// a copied series shares its storage with the original until one of them is
+// written to; reading either one, in any way, must keep it shared.
+void test_copy_on_write() {
+  mymap_t m{};
+  auto score = m.add_series<int64_t>("score").value();
+  for (int i = 0; i < 100; ++i) {
+    score["k" + std::to_string(i)] = i;
+  }
+  assert(m.copy_series("score", "snapshot"));
+  auto shared = [&m](const std::string &sel) {
+    auto mem = m.series_memory(sel).value();
+    auto usage = m.memory_usage().series.at(sel).values;
+    assert(mem.unique_bytes == usage.unique_bytes &&
+           mem.shared_bytes == usage.shared_bytes);
+    assert((mem.unique_bytes == 0) != (mem.shared_bytes == 0));
+    return mem.shared_bytes > 0;
+  };
+  assert(shared("score") && shared("snapshot"));
+
+  auto version = m.series_version("snapshot");
+  auto snapshot = m.get_series<int64_t>("snapshot").value();
+  auto text = m.str_cols({"score", "snapshot"});
+  assert(text.find("(int) snapshot: 42") != std::string::npos);
+  assert(snapshot.at("k42") == 42 && m.get_as_variant("snapshot", "k7"));
+  int64_t sum = 0;
+  snapshot.for_all([&sum](const auto &, auto, const auto &v) { sum += v; });
+  assert(sum == 4950);
+  assert(shared("score") && shared("snapshot"));
+  assert(m.series_version("snapshot") == version);
+
+  snapshot["k3"] = -1;
+  assert(!shared("score") && !shared("snapshot"));
+  assert(m.series_version("snapshot") != version);
+  assert(snapshot.at("k3") == -1 && score.at("k3") == 3);
+}
+
+// writes a map in the binary format and reads it back.
+template <typename Map>
+Map binary_round_trip(const Map &m) {
+  std::stringstream out;
+  m.write_binary(out);
+  auto bytes = out.str();
+  return Map::read_binary(
+      std::as_bytes(std::span(bytes.data(), bytes.size())));
+}
+
+// checks that a series was read back with the same values at the same
+// indices, stored the same way.
+template <typename V, typename Map>
+void check_same_series(Map &from, Map &to, const std::string &sel) {
+  auto a = from.template get_series<V>(sel).value();
+  auto b = to.template get_series<V>(sel).value();
+  auto ua = from.memory_usage().series.at(sel);
+  auto ub = to.memory_usage().series.at(sel);
+  assert(a.size() == b.size());
+  assert(ua.dense == ub.dense && ua.encoding == ub.encoding);
+  a.for_all([&to, &b](const auto &k, auto loc, const auto &v) {
+    assert(to.find_index(k) && b.find(loc) != nullptr);
+    assert(*b.find(loc) == v && b.at(k)->get() == v);
+  });
+}
+
+// every key and value survives the binary format at its index, whatever
+// its type, layout and encoding, and erased rows leave the same gaps.
+void test_binary_round_trip() {
+  mymap_t m{};
+  auto flag = m.add_series<bool>("flag", "", mvmap::series_layout::dense);
+  auto weight =
+      m.add_series<double>("weight", "", mvmap::series_layout::sparse);
+  auto count = m.add_series<int64_t>("count").value();
+  auto label = m.add_series<std::string>("label").value();
+  auto note = m.add_series<std::string>("note").value();
+  auto key = [](int i) { return "k" + std::to_string(i); };
+  for (int i = 0; i < 150; ++i) {
+    (*flag)[key(i)] = i % 3 == 0;
+    if (i % 7 == 0) {
+      (*weight)[key(i)] = i * -0.5;
+    }
+    count[key(i)] = int64_t(i) * i - 1000;
+    label[key(i)] = i % 4 == 0 ? "" : "l" + std::to_string(i % 4);
+    if (i % 11 == 0) {
+      note[key(i)] = std::string(40, char('a' + i % 26));
+    }
+  }
+  count[key(1)] = std::numeric_limits<int64_t>::min();
+  count[key(2)] = std::numeric_limits<int64_t>::max();
+  m.set_series_encoding("label", mvmap::series_encoding::dictionary);
+  m.track_series_stats("weight");
+  m.add_index("count");
+  m.remove_if([key](const std::string &k, auto) {
+    return k == key(0) || k == key(64) || k.back() == '5';
+  });
+
+  auto n = binary_round_trip(m);
+  assert(n.size() == m.size() && n.index_capacity() == m.index_capacity());
+  for (int i = 0; i < 150; ++i) {
+    assert(n.find_index(key(i)) == m.find_index(key(i)));
+  }
+  check_same_series<bool>(m, n, "flag");
+  check_same_series<double>(m, n, "weight");
+  check_same_series<int64_t>(m, n, "count");
+  check_same_series<std::string>(m, n, "label");
+  check_same_series<std::string>(m, n, "note");
+  assert(n.series_is_dense("flag") && !n.series_is_dense("weight"));
+  assert(n.get_series<std::string>("label")->dictionary() != nullptr);
+  const auto *st = n.get_series<double>("weight")->stats();
+  assert(st != nullptr && st->count() == weight->size() &&
+         st->sum() == weight->stats()->sum());
+  assert(n.index_count("count", mvmap::cmp_op::lt, int64_t{0}) ==
+         m.index_count("count", mvmap::cmp_op::lt, int64_t{0}));
+
+  // pair keys are stored as two arrays.
+  using edge_map =
+      mvmap::mvmap<std::pair<uint64_t, uint64_t>, bool, double, int64_t,
+                   std::string>;
+  edge_map e{};
+  auto w = e.add_series<double>("w").value();
+  for (uint64_t i = 0; i < 100; ++i) {
+    w[{i, i * 3 + 1}] = double(i) / 4;
+  }
+  e.remove_if([](const auto &k, auto) { return k.first % 9 == 4; });
+  auto f = binary_round_trip(e);
+  assert(f.size() == 89 && f.index_capacity() == e.index_capacity());
+  for (uint64_t i = 0; i < 100; ++i) {
+    assert(f.find_index({i, i * 3 + 1}) == e.find_index({i, i * 3 + 1}));
+  }
+  check_same_series<double>(e, f, "w");
+}
+
+// each cell written in an encoded series gets its own reference, and only
+// values actually written are added to the dictionary.
+void test_encoded_cells() {
+  mymap_t m{};
+  auto name = m.add_series<std::string>("name").value();
+  auto num = m.add_series<int64_t>("num").value();
+  std::vector<std::string> initial = {"a", "b", "a", "c"};
+  for (int i = 0; i < 4; ++i) {
+    name["k" + std::to_string(i)] = initial[i];
+    num["k" + std::to_string(i)] = i + 1;
+  }
+  m.set_series_encoding("name", mvmap::series_encoding::dictionary);
+  m.set_series_encoding("num", mvmap::series_encoding::dictionary);
+  m.track_series_stats("num");
+
+  name["k1"] = name["k3"];
+  assert(name.at("k1")->get() == "c" && name.at("k3")->get() == "c");
+  auto &first = name["k0"];
+  auto &third = name["k2"];
+  first = "p";
+  third = "q";
+  assert(name.at("k0")->get() == "p" && name.at("k2")->get() == "q");
+
+  // a new cell's value goes into the dictionary only once it is written.
+  m.add_key("k4");
+  name["k4"] = "z";
+  std::set<std::string> codes;
+  name.dictionary()->for_all(
+      [&codes](const std::string &v, auto) { codes.insert(v); });
+  assert((codes == std::set<std::string>{"a", "b", "c", "p", "q", "z"}));
+  assert(name.size() == 5 && name.at("k4")->get() == "z");
+
+  // the statistics see a cell copied from another.
+  num["k0"] = num["k2"];
+  num["k4"] = 7;
+  assert(num.at("k0") == 3 && num.stats()->sum() == 3 + 2 + 3 + 4 + 7);
+  assert(num.stats()->count() == 5 && !num.dictionary()->contains(0));
+}
+
+// a cached selection is returned only for the same rule, and only while the
+// keys and the series the rule read are unchanged.
+void test_selection_cache() {
+  mymap_t m{};
+  auto v = m.add_series<int64_t>("v").value();
+  auto w = m.add_series<int64_t>("w").value();
+  for (int64_t i = 0; i < 10; ++i) {
+    v["k" + std::to_string(i)] = i;
+    w["k" + std::to_string(i)] = -i;
+  }
+  mvmap::selection sel(m.index_capacity());
+  sel.insert(m.find_index("k7").value());
+  m.cache_selection(42, "v>6", {"v"}, sel);
+
+  auto hit = m.find_cached_selection(42, "v>6", {"v"});
+  assert(hit.has_value() && hit->indices() == sel.indices());
+  // the same hash for another rule is a collision, not a hit.
+  assert(!m.find_cached_selection(42, "v>5", {"v"}).has_value());
+  assert(!m.find_cached_selection(42, "v>6", {"v", "w"}).has_value());
+
+  // writing another series leaves it current; writing the one read doesn't.
+  w["k0"] = 1;
+  assert(m.find_cached_selection(42, "v>6", {"v"}).has_value());
+  v["k0"] = 1;
+  assert(!m.find_cached_selection(42, "v>6", {"v"}).has_value());
+
+  m.cache_selection(42, "v>6", {"v"}, sel);
+  m.add_key("k10");
+  assert(!m.find_cached_selection(42, "v>6", {"v"}).has_value());
+}
+
+int main() {
+  test_series();
+  test_layouts();
+  test_key_dictionary();
+  test_remove_renumber();
+  test_copy_on_write();
+  test_binary_round_trip();
+  test_encoded_cells();
+  test_selection_cache();
+  std::cout << "all tests passed\n";
+}
@@ -0,0 +1,35 @@
+// Copyright 2021 Lawrence Livermore National Security, LLC and other CLIPPy
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <boost/json.hpp>
+
+#include "clippy/clippy.hpp"
+#include "testgraph.hpp"
+
+static const std::string method_name = "track_components";
+static const std::string state_name = "INTERNAL";
+
+int main(int argc, char **argv) {
+  clippy::clippy clip{method_name,
+                      "Keeps the connected components of a TestGraph up to "
+                      "date as nodes and edges are added, so "
+                      "connected_components need not recompute them"};
+  clip.add_optional<bool>("on", "False to stop tracking", true);
+  clip.add_required_state<testgraph::testgraph>(state_name,
+                                                "Internal container");
+  clip.returns_self();
+
+  // no object-state requirements in constructor
+  if (clip.parse(argc, argv)) {
+    return 0;
+  }
+
+  auto on = clip.get<bool>("on");
+  auto the_graph = clip.get_state<testgraph::testgraph>(state_name);
+  the_graph.track_components(on);
+  clip.set_state(state_name, the_graph);
+  clip.return_self();
+  return 0;
+}
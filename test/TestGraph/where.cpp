@@ -1,104 +1,282 @@
 #include <boost/json.hpp>
 #include <boost/json/src.hpp>
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
 #include <jsonlogic/src.hpp>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
+#include <variant>
 #include <vector>
 
+#include "clippy/rule-kernel.hpp"
 #include "clippy/selector.hpp"
 #include "jsonlogic/logic.hpp"
 #include "testgraph.hpp"
 
+// maps a comparison to the index operator that answers it, if any.
+std::optional<mvmap::cmp_op> as_index_op(clippy::cmp_kind op) {
+  switch (op) {
+    case clippy::cmp_kind::eq:
+      return mvmap::cmp_op::eq;
+    case clippy::cmp_kind::lt:
+      return mvmap::cmp_op::lt;
+    case clippy::cmp_kind::le:
+      return mvmap::cmp_op::le;
+    case clippy::cmp_kind::gt:
+      return mvmap::cmp_op::gt;
+    case clippy::cmp_kind::ge:
+      return mvmap::cmp_op::ge;
+    default:
+      return std::nullopt;
+  }
+}
+
+// appends a serialization of v to out in which object members are sorted by
+// key, so that equivalent rules serialize identically.
+void canonicalize(const boost::json::value& v, std::string& out) {
+  if (const auto* obj = v.if_object()) {
+    std::vector<std::string> keys;
+    for (const auto& kv : *obj) {
+      keys.emplace_back(kv.key());
+    }
+    std::sort(keys.begin(), keys.end());
+    out += '{';
+    for (const auto& key : keys) {
+      out += boost::json::serialize(boost::json::value(key));
+      out += ':';
+      canonicalize(obj->at(key), out);
+      out += ',';
+    }
+    out += '}';
+  } else if (const auto* arr = v.if_array()) {
+    out += '[';
+    for (const auto& el : *arr) {
+      canonicalize(el, out);
+      out += ',';
+    }
+    out += ']';
+  } else {
+    out += boost::json::serialize(v);
+  }
+}
+
+// 64-bit FNV-1a hash of the canonical form of a rule.
+uint64_t rule_hash(const std::string& canon) {
+  uint64_t h = 14695981039346656037ULL;
+  for (unsigned char c : canon) {
+    h = (h ^ c) * 1099511628211ULL;
+  }
+  return h;
+}
+
+// A prepared_rule is a jsonlogic rule whose variables have been resolved
+// against the series of an mvmap. Variable names are parsed, and their series
+// looked up, once at construction; evaluating the rule for a row then only
+// reads the row's values out of the resolved series.
+//
+// The rule is evaluated for every row up front, into a selection. The
+// selection comes from the mvmap's selection cache if the same rule was
+// evaluated before and none of the series it reads have changed since,
+// otherwise from an index probe or a scan, and is then cached. Rules that
+// compare a single series against a constant are scanned with a compiled
+// kernel rather than the generic jsonlogic evaluator.
 template <typename M>
-auto parse_where_expression(M& mvmap_, boost::json::object& expression,
-                            boost::json::object& submission_data) {
-  // std::cerr << "  parse_where_expression: expression: " << expression
-  //           << std::endl;
-  boost::json::object exp2(expression);
+class prepared_rule {
+  using series_handle =
+      typename decltype(std::declval<M&>().get_variant_series(
+          std::string{}))::value_type;
+
+  struct bound_var {
+    std::string name;                     // full selector, e.g. "node.degree"
+    std::optional<series_handle> series;  // nullopt if there is no series
+  };
+
+  // an index probe is used instead of a scan when it selects at most this
+  // fraction of the rows.
+  static constexpr double max_probe_selectivity = 0.25;
+
+  std::shared_ptr<jsonlogic::logic_rule> jlrule;
+  std::vector<bound_var> bound;
+  boost::json::object* submission_data;
+  std::optional<mvmap::selection> selected;
+
+  // true if pred compares the rule's only variable against a constant.
+  bool is_single_series(const std::optional<clippy::var_cmp_rule>& pred) {
+    return pred.has_value() && bound.size() == 1 &&
+           bound[0].series.has_value() && bound[0].name == pred->var;
+  }
+
+  // answers single-comparison rules on an indexed series by probing the
+  // index, when the estimated selectivity makes that cheaper than a scan.
+  void plan_index_probe(M& mvmap_,
+                        const std::optional<clippy::var_cmp_rule>& pred) {
+    if (!is_single_series(pred)) {
+      return;
+    }
+    auto op = as_index_op(pred->op);
+    auto var_tail = selector(pred->var).tail();
+    if (!op.has_value() || !var_tail.has_value() ||
+        !mvmap_.has_index(var_tail.value())) {
+      return;
+    }
+    // rows without a value would compare as null; leave those to the scan.
+    auto nrows = std::visit([](auto& sproxy) { return sproxy.size(); },
+                            *bound[0].series);
+    if (nrows != mvmap_.size()) {
+      return;
+    }
+    std::string tail = var_tail.value();
+    std::visit(
+        [&](const auto& b) {
+          auto ct = mvmap_.index_count(tail, *op, b);
+          if (ct && *ct <= max_probe_selectivity * nrows) {
+            selected = mvmap_.index_select(tail, *op, b);
+          }
+        },
+        pred->constant);
+  }
 
-  std::shared_ptr<jsonlogic::logic_rule> jlrule =
-      std::make_shared<jsonlogic::logic_rule>(
-          jsonlogic::create_logic(exp2["rule"]));
-  // std::cerr << "past create_logic\n";
-  auto vars = jlrule->variable_names();
-  // boost::json::object submission_data{};
-  // jsonlogic::any_expr expression_rule_;
-
-  // we use expression_rule_ (and expression_rule; see below) in order to avoid
-  // having to recompute this every time we call the lambda.
-  // std::tie(expression_rule_, vars, std::ignore) =
-  //     jsonlogic::create_logic(exp2["rule"]);
-
-  // this works around a deficiency in C++ compilers where
-  // unique pointers moved into a lambda cannot be moved into
-  // an std::function.
-  // jsonlogic::expr* rawexpr = expression_rule_.release();
-  // std::shared_ptr<jsonlogic::expr> expression_rule{rawexpr};
-  // std::shared_ptr<jsonlogic::logic_rule> jlshared{&jlrule};
-
-  // std::cerr << "parse_where: # of vars: " << vars.size() << std::endl;
-  // for (const auto& var : vars) {
-  //   std::cerr << "  apply_jl var dump: var: " << var << std::endl;
-  // }
-
-  auto apply_jl = [&expression, jlrule, &mvmap_,
-                   &submission_data](mvmap::locator loc) mutable {
-    auto vars = jlrule->variable_names();
-    // std::cerr << "    apply_jl:  # of vars: " << vars.size() << std::endl;
-    for (const auto& var : vars) {
-      // std::cerr << "    apply_jl: var: " << var << std::endl;
+  // scans with a kernel compiled for the series' value type. Rows without a
+  // value are left to the generic evaluator. Returns false if there is no
+  // kernel for the rule.
+  bool scan_with_kernel(M& mvmap_,
+                        const std::optional<clippy::var_cmp_rule>& pred,
+                        mvmap::selection& scanned) {
+    if (!is_single_series(pred)) {
+      return false;
+    }
+    return std::visit(
+        [&](auto& sproxy) {
+          using V = std::remove_cvref_t<decltype(*sproxy.find({}))>;
+          auto kernel = clippy::var_cmp_kernel<V>::compile(*pred);
+          if (!kernel) {
+            return false;
+          }
+          // a dictionary-encoded series is compared once per distinct value,
+          // and each row only looks up the result for its code.
+          if (const auto* dict = sproxy.dictionary()) {
+            std::vector<uint8_t> hit(dict->capacity());
+            for (size_t code = 0; code < hit.size(); ++code) {
+              hit[code] = (*kernel)(dict->key_at(code)) ? 1 : 0;
+            }
+            mvmap_.for_all([&](const auto& /*unused*/, const auto& loc) {
+              const auto* code = sproxy.find_code(loc);
+              if (code != nullptr ? hit[*code] != 0 : evaluate(loc)) {
+                scanned.insert(loc);
+              }
+            });
+            return true;
+          }
+          mvmap_.for_all([&](const auto& /*unused*/, const auto& loc) {
+            const auto* val = sproxy.find(loc);
+            if (val != nullptr ? (*kernel)(*val) : evaluate(loc)) {
+              scanned.insert(loc);
+            }
+          });
+          return true;
+        },
+        *bound[0].series);
+  }
+
+ public:
+  prepared_rule(M& mvmap_, boost::json::object& expression,
+                boost::json::object& submission_data)
+      : jlrule(std::make_shared<jsonlogic::logic_rule>(
+            jsonlogic::create_logic(expression["rule"]))),
+        submission_data(&submission_data) {
+    std::vector<std::string> deps;  // the series the rule reads
+    for (const auto& var : jlrule->variable_names()) {
       auto var_sel = selector(std::string(var));
-      // std::cerr << "  apply_jl: var_sel = " << var_sel << std::endl;
-      // if (!var_sel.headeq("node")) {
-      //   std::cerr << "selector is not a node selector; skipping." <<
-      //   std::endl; continue;
-      // }
-      auto var_tail = var_sel.tail().value();
-      std::string var_str = std::string(var_sel);
-      // std::cerr << "    apply_jl: var: " << var_sel << std::endl;
-      if (mvmap_.has_series(var_tail)) {
-        // std::cerr << "    apply_jl: has series: " << var_sel << std::endl;
-        auto val = mvmap_.get_as_variant(var_tail, loc);
-        if (val.has_value()) {
-          // std::cerr << "    apply_jl: val has value" << std::endl;
-          std::visit(
-              [&submission_data, &loc, &var_str](auto&& v) {
-                submission_data[var_str] = boost::json::value(v);
-                // std::cerr << "    apply_jl: submission_data[" << var_str
-                //           << "] = " << v << " at loc " << loc << "."
-                //           << std::endl;
-              },
-              *val);
-        } else {
-          std::cerr << "    apply_jl: no value for " << var_sel << std::endl;
-          submission_data[var_str] = boost::json::value();
-        }
-      } else {
-        std::cerr << "    apply_jl: no series for " << var_sel << std::endl;
+      auto var_tail = var_sel.tail();
+      auto series = var_tail.has_value()
+                        ? mvmap_.get_variant_series(var_tail.value())
+                        : std::nullopt;
+      if (var_tail.has_value()) {
+        deps.emplace_back(var_tail.value());
+      }
+      if (!series.has_value()) {
+        std::cerr << "    prepared_rule: no series for " << var_sel
+                  << std::endl;
       }
+      bound.push_back(bound_var{std::string(var_sel), std::move(series)});
     }
-    // std::cerr << "    apply_jl: submission_data: " << submission_data
-    //           << std::endl;
-    auto res = jlrule->apply(jsonlogic::json_accessor(submission_data));
-    // jsonlogic::apply(
-    //     *expression_rule, jsonlogic::data_accessor(submission_data));
-    // std::cerr << "    apply_jl: res: " << res << std::endl;
+    std::sort(deps.begin(), deps.end());
+    deps.erase(std::unique(deps.begin(), deps.end()), deps.end());
+
+    std::string canon;
+    canonicalize(expression["rule"], canon);
+    auto hash = rule_hash(canon);
+    selected = mvmap_.find_cached_selection(hash, canon, deps);
+    if (selected.has_value()) {
+      return;
+    }
+    auto pred = clippy::parse_var_cmp(expression["rule"]);
+    plan_index_probe(mvmap_, pred);
+    if (!selected.has_value()) {
+      mvmap::selection scanned(mvmap_.index_capacity());
+      if (!scan_with_kernel(mvmap_, pred, scanned)) {
+        mvmap_.for_all(
+            [this, &scanned](const auto& /*unused*/, const auto& loc) {
+              if (evaluate(loc)) {
+                scanned.insert(loc);
+              }
+            });
+      }
+      selected = std::move(scanned);
+    }
+    mvmap_.cache_selection(hash, canon, deps, *selected);
+  }
+
+  // fills the submission data from the resolved series for the row at loc.
+  void bind_row(mvmap::locator loc) {
+    for (auto& bv : bound) {
+      if (!bv.series.has_value()) {
+        continue;
+      }
+      auto& slot = (*submission_data)[bv.name];
+      std::visit(
+          [&slot, &loc](auto& sproxy) {
+            const auto* val = sproxy.find(loc);
+            if (val != nullptr) {
+              slot = boost::json::value(*val);
+            } else {
+              slot = boost::json::value();
+            }
+          },
+          *bv.series);
+    }
+  }
+
+  // evaluates the rule for a single row.
+  bool evaluate(mvmap::locator loc) {
+    bind_row(loc);
+    auto res = jlrule->apply(jsonlogic::json_accessor(*submission_data));
     return jsonlogic::unpack_value<bool>(res);
-  };
+  }
+
+  bool operator()(mvmap::locator loc) const {
+    return selected.has_value() && selected->contains(loc);
+  }
+};
 
-  return apply_jl;
+template <typename M>
+auto parse_where_expression(M& mvmap_, boost::json::object& expression,
+                            boost::json::object& submission_data) {
+  boost::json::object exp2(expression);
+  return prepared_rule<M>(mvmap_, exp2, submission_data);
 }
 
-std::vector<testgraph::node_t> where_nodes(const testgraph::testgraph& g,
+std::vector<testgraph::node_t> where_nodes(testgraph::testgraph& g,
                                            boost::json::object& expression) {
   std::vector<testgraph::node_t> filtered_results;
   // boost::json::object exp2(expression);
 
   // std::cerr << "  where: expression: " << expression << std::endl;
 
-  auto nodemap = g.nodemap();
+  auto& nodemap = g.nodemap();
   boost::json::object submission_data;
   auto apply_jl = parse_where_expression(nodemap, expression, submission_data);
   nodemap.for_all([&filtered_results, &apply_jl, &nodemap,
@@ -5,6 +5,7 @@
 
 #include <boost/json.hpp>
 #include <clippy/clippy.hpp>
+#include <clippy/rule-kernel.hpp>
 #include <jsonlogic/src.hpp>
 #include <set>
 
@@ -31,7 +32,17 @@ int main(int argc, char **argv) {
   // Expression here
   jsonlogic::logic_rule jlrule = jsonlogic::create_logic(expression["rule"]);
 
-  auto apply_jl = [&jlrule](int value) {
+  // simple comparisons of the value against a constant skip jsonlogic.
+  std::optional<clippy::var_cmp_kernel<int>> kernel;
+  if (auto pred = clippy::parse_var_cmp(expression["rule"]);
+      pred && pred->var == "value") {
+    kernel = clippy::var_cmp_kernel<int>::compile(*pred);
+  }
+
+  auto apply_jl = [&jlrule, &kernel](int value) {
+    if (kernel) {
+      return (*kernel)(value);
+    }
     return truthy(jlrule.apply(jsonlogic::json_accessor({{"value", value}})));
   };
 
@@ -0,0 +1,61 @@
+// Copyright 2020 Lawrence Livermore National Security, LLC and other CLIPPy
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+// Edges per second added to an empty graph one add_edge() at a time, and in
+// bulk with add_edges(), from (src, dst) names. See graph_load_edges for
+// edge list files.
+//
+// usage: graph_add_edges [num_nodes] [num_edges]   (default: 1000000 4000000)
+
+#include <boost/json.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "testgraph.hpp"
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+double secs_since(bench_clock::time_point start) {
+  return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t nv = argc > 1 ? std::stoull(argv[1]) : 1000000;
+  size_t ne = argc > 2 ? std::stoull(argv[2]) : 4000000;
+
+  std::vector<testgraph::edge_t> edges(ne);
+  uint64_t x = 88172645463325252ULL;
+  for (auto &[src, dst] : edges) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    src = std::to_string(x % nv);
+    dst = std::to_string((x >> 32) % nv);
+  }
+
+  auto start = bench_clock::now();
+  testgraph::testgraph one;
+  for (const auto &[src, dst] : edges) {
+    one.add_edge(src, dst);
+  }
+  double secs = secs_since(start);
+  std::cout << "add_edge   " << secs << " s  " << double(ne) / secs / 1e6
+            << " M edges/s  " << one.ne() << " edges" << std::endl;
+
+  start = bench_clock::now();
+  testgraph::testgraph bulk;
+  bulk.add_edges(edges);
+  secs = secs_since(start);
+  std::cout << "add_edges  " << secs << " s  " << double(ne) / secs / 1e6
+            << " M edges/s  " << bulk.ne() << " edges" << std::endl;
+}
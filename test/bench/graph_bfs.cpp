@@ -0,0 +1,70 @@
+// Copyright 2020 Lawrence Livermore National Security, LLC and other CLIPPy
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+// Traversed edges per second (TEPS) of a breadth-first search on a random
+// undirected graph, top-down only and direction-optimizing, on 1, 2, 4, ...
+// threads.
+//
+// usage: graph_bfs [num_nodes] [num_edges] [num_sources]
+//        (default: 1000000 8000000 8)
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bfs.hpp"
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+double secs_since(bench_clock::time_point start) {
+  return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t nv = argc > 1 ? std::stoull(argv[1]) : 1000000;
+  size_t ne = argc > 2 ? std::stoull(argv[2]) : 8000000;
+  size_t num_sources = argc > 3 ? std::stoull(argv[3]) : 8;
+
+  std::vector<std::pair<mvmap::index, mvmap::index>> pairs;
+  pairs.reserve(2 * ne);
+  uint64_t x = 88172645463325252ULL;
+  for (size_t i = 0; i < ne; ++i) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    pairs.emplace_back(x % nv, (x >> 32) % nv);
+    pairs.emplace_back(pairs.back().second, pairs.back().first);
+  }
+  testgraph::csr out(nv, pairs);
+  testgraph::csr in(nv, pairs);
+
+  unsigned max_threads = std::max(1U, std::thread::hardware_concurrency());
+  for (bool direction_optimizing : {false, true}) {
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+      double secs = 0;
+      size_t edges = 0;
+      for (size_t s = 0; s < num_sources; ++s) {
+        auto start = bench_clock::now();
+        auto result = testgraph::bfs(out, in, (s * 7919) % nv, -1, threads,
+                                     direction_optimizing);
+        secs += secs_since(start);
+        edges += result.edges_traversed;
+      }
+      std::cout << (direction_optimizing ? "direction-optimizing, "
+                                         : "top-down,             ")
+                << threads << " threads  " << secs / double(num_sources)
+                << " s  " << double(edges) / secs / 1e6 << " M TEPS"
+                << std::endl;
+    }
+  }
+}
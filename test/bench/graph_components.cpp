@@ -0,0 +1,131 @@
+// Copyright 2020 Lawrence Livermore National Security, LLC and other CLIPPy
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+// Time to label the connected components of a random graph with a queue
+// BFS over adjacency lists, as connected_components used to, and with the
+// concurrent union-find over a CSR on 1, 2, 4, ... threads; the cost of
+// keeping incremental_components up to date edge by edge; and relabeling a
+// testgraph after each of a run of add_edge() calls, with and without
+// track_components.
+//
+// usage: graph_components [num_nodes] [num_edges]   (default: 1000000 10000000)
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <numeric>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "components.hpp"
+#include "testgraph.hpp"
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+double secs_since(bench_clock::time_point start) {
+  return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+// adds rounds edges to g one at a time, relabeling it after each.
+double time_relabel(testgraph::testgraph &g, size_t nv, size_t rounds) {
+  auto start = bench_clock::now();
+  for (size_t i = 0; i < rounds; ++i) {
+    g.add_edge(std::to_string(i * 7919 % nv), std::to_string(i * 104729 % nv));
+    auto labels = g.component_labels();
+  }
+  return secs_since(start);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t nv = argc > 1 ? std::stoull(argv[1]) : 1000000;
+  size_t ne = argc > 2 ? std::stoull(argv[2]) : 10000000;
+
+  std::vector<std::pair<mvmap::index, mvmap::index>> pairs(ne);
+  uint64_t x = 88172645463325252ULL;
+  for (auto &[src, dst] : pairs) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    src = x % nv;
+    dst = (x >> 32) % nv;
+  }
+
+  auto start = bench_clock::now();
+  std::vector<std::vector<int64_t>> adj(nv);
+  for (auto [src, dst] : pairs) {
+    adj[src].push_back(int64_t(dst));
+    adj[dst].push_back(int64_t(src));
+  }
+  std::vector<bool> visited(nv, false);
+  std::vector<int64_t> components(nv);
+  std::iota(components.begin(), components.end(), 0);
+  for (size_t i = 0; i < nv; ++i) {
+    if (!visited[i]) {
+      std::queue<int64_t> q;
+      q.push(int64_t(i));
+      while (!q.empty()) {
+        int64_t v = q.front();
+        q.pop();
+        visited[v] = true;
+        for (int64_t u : adj[v]) {
+          if (!visited[u]) {
+            q.push(u);
+            components[u] = components[i];
+          }
+        }
+      }
+    }
+  }
+  std::cout << "queue bfs        " << secs_since(start) << " s" << std::endl;
+
+  start = bench_clock::now();
+  testgraph::csr edges(nv, pairs);
+  std::cout << "csr build        " << secs_since(start) << " s" << std::endl;
+
+  unsigned max_threads = std::max(1U, std::thread::hardware_concurrency());
+  for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+    start = bench_clock::now();
+    auto labels = testgraph::connected_components(edges, threads);
+    double secs = secs_since(start);
+    size_t roots = 0;
+    for (size_t i = 0; i < nv; ++i) {
+      roots += labels[i] == i ? 1 : 0;
+    }
+    std::cout << "union-find, " << threads << " threads  " << secs << " s  "
+              << double(ne) / secs / 1e6 << " M edges/s  " << roots
+              << " components" << std::endl;
+  }
+
+  start = bench_clock::now();
+  testgraph::incremental_components tracked;
+  for (auto [src, dst] : pairs) {
+    tracked.unite(src, dst);
+  }
+  double secs = secs_since(start);
+  std::cout << "incremental      " << secs << " s  "
+            << double(ne) / secs / 1e6 << " M edges/s" << std::endl;
+
+  size_t rounds = 20;
+  std::vector<testgraph::edge_t> named(std::min<size_t>(ne, 1000000));
+  for (size_t i = 0; i < named.size(); ++i) {
+    named[i] = {std::to_string(pairs[i].first % (nv / 10 + 1)),
+                std::to_string(pairs[i].second % (nv / 10 + 1))};
+  }
+  testgraph::testgraph g;
+  g.add_edges(named);
+  double full = time_relabel(g, nv / 10 + 1, rounds);
+  g.track_components();
+  double incremental = time_relabel(g, nv / 10 + 1, rounds);
+  std::cout << "add_edge + relabel, " << g.nv() << " nodes  recompute "
+            << full / double(rounds) << " s  tracked "
+            << incremental / double(rounds) << " s" << std::endl;
+}
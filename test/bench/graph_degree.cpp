@@ -0,0 +1,75 @@
+// Copyright 2020 Lawrence Livermore National Security, LLC and other CLIPPy
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+// Time to compute node degrees on a random graph by scanning the edge keys
+// for each node, as testgraph used to, and from the CSR adjacency index.
+//
+// usage: graph_degree [num_nodes] [num_edges] [num_scanned]
+//        (default: 100000 1000000 100)
+
+#include <boost/json.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "testgraph.hpp"
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+double secs_since(bench_clock::time_point start) {
+  return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t nv = argc > 1 ? std::stoull(argv[1]) : 100000;
+  size_t ne = argc > 2 ? std::stoull(argv[2]) : 1000000;
+  size_t scanned = argc > 3 ? std::stoull(argv[3]) : 100;
+
+  testgraph::testgraph g;
+  uint64_t x = 88172645463325252ULL;
+  auto next = [&x, nv]() {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return std::to_string(x % nv);
+  };
+  for (size_t i = 0; i < ne; ++i) {
+    g.add_edge(next(), next());
+  }
+  auto nodes = g.nodes();
+
+  auto start = bench_clock::now();
+  size_t total = 0;
+  for (size_t i = 0; i < scanned && i < nodes.size(); ++i) {
+    auto id = g.node_index(nodes[i]);
+    for (const auto &[src, dst] : g.edgemap().keys()) {
+      total += src == id || dst == id ? 1 : 0;
+    }
+  }
+  double scan_secs = secs_since(start);
+  std::cout << "scan       " << scan_secs / double(scanned) << " s per node, "
+            << scan_secs / double(scanned) * double(nodes.size())
+            << " s for all " << nodes.size() << " nodes  " << total
+            << " total degree of those scanned" << std::endl;
+
+  start = bench_clock::now();
+  const auto &adj = g.adjacency_index();
+  std::cout << "csr build  " << secs_since(start) << " s  "
+            << adj.out_edges().num_entries() << " edges" << std::endl;
+
+  start = bench_clock::now();
+  total = 0;
+  for (const auto &node : nodes) {
+    total += g.degree(node);
+  }
+  std::cout << "csr degree " << secs_since(start) << " s for all nodes  "
+            << total << " total degree" << std::endl;
+}
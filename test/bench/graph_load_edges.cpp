@@ -0,0 +1,90 @@
+// Copyright 2020 Lawrence Livermore National Security, LLC and other CLIPPy
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+// Throughput of loading a weighted tsv edge list: tokenizing the text with a
+// byte-at-a-time and an SSE2 separator search, on one thread and on all of
+// them; and the whole load_edge_list path of mapping, parsing and adding the
+// edges and their weights to an empty graph.
+//
+// usage: graph_load_edges [num_nodes] [num_edges] [dir]
+//                                             (default: 1000000 4000000 /tmp)
+
+#include <boost/json.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "edge_list.hpp"
+#include "testgraph.hpp"
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+double secs_since(bench_clock::time_point start) {
+  return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+template <bool Simd>
+void time_parse(const std::string &what, std::string_view text,
+                unsigned num_threads) {
+  auto start = bench_clock::now();
+  testgraph::edge_list list;
+  testgraph::parse_edge_list<Simd>(text, testgraph::edge_list_format::tsv,
+                                   true, list, num_threads);
+  double secs = secs_since(start);
+  std::cout << what << "  " << secs << " s  "
+            << double(text.size()) / secs / 1e6 << " MB/s  " << list.size()
+            << " edges" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t nv = argc > 1 ? std::stoull(argv[1]) : 1000000;
+  size_t ne = argc > 2 ? std::stoull(argv[2]) : 4000000;
+  std::string dir = argc > 3 ? argv[3] : "/tmp";
+
+  std::string text;
+  uint64_t x = 88172645463325252ULL;
+  for (size_t i = 0; i < ne; ++i) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    text += std::to_string(x % nv) + '\t' + std::to_string((x >> 32) % nv) +
+            '\t' + std::to_string(double(x % 1000) / 8) + '\n';
+  }
+  std::string path = dir + "/graph_load_edges.tsv";
+  {
+    std::ofstream os(path, std::ios::binary);
+    os.write(text.data(), std::streamsize(text.size()));
+  }
+  unsigned all = testgraph::thread_count(text.size(), 0);
+  std::cout << "nv=" << nv << " ne=" << ne << " " << text.size() << " bytes "
+            << all << " threads" << std::endl;
+
+  time_parse<false>("scalar 1 thread", text, 1);
+  time_parse<true>("simd   1 thread", text, 1);
+  time_parse<false>("scalar threads ", text, all);
+  time_parse<true>("simd   threads ", text, all);
+
+  auto start = bench_clock::now();
+  auto list = testgraph::read_edge_list(path, testgraph::edge_list_format::tsv,
+                                        true);
+  testgraph::testgraph g;
+  g.add_edges(list, std::string("weight"));
+  double secs = secs_since(start);
+  std::cout << "load + add      " << secs << " s  "
+            << double(list.bytes) / secs / 1e6 << " MB/s  " << g.ne()
+            << " edges" << std::endl;
+
+  std::filesystem::remove(path);
+  return 0;
+}
@@ -0,0 +1,87 @@
+// Copyright 2020 Lawrence Livermore National Security, LLC and other CLIPPy
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+// Time per PageRank iteration on a random graph, pushing rank along the out
+// edges one edge at a time, and pulling it with spmv() over the transposed
+// CSR on 1, 2, 4, ... threads.
+//
+// usage: graph_pagerank [num_nodes] [num_edges] [iterations]
+//        (default: 1000000 10000000 20)
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pagerank.hpp"
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+double secs_since(bench_clock::time_point start) {
+  return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t nv = argc > 1 ? std::stoull(argv[1]) : 1000000;
+  size_t ne = argc > 2 ? std::stoull(argv[2]) : 10000000;
+  size_t iterations = argc > 3 ? std::stoull(argv[3]) : 20;
+
+  std::vector<std::pair<mvmap::index, mvmap::index>> pairs(ne);
+  uint64_t x = 88172645463325252ULL;
+  for (auto &[src, dst] : pairs) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    src = x % nv;
+    dst = (x >> 32) % nv;
+  }
+
+  std::vector<double> out_degree(nv, 0);
+  for (auto [src, dst] : pairs) {
+    out_degree[src] += 1;
+  }
+  std::vector<double> rank(nv, 1.0 / double(nv));
+  std::vector<double> next(nv);
+  auto start = bench_clock::now();
+  for (size_t it = 0; it < iterations; ++it) {
+    double dangling = 0;
+    for (size_t v = 0; v < nv; ++v) {
+      dangling += out_degree[v] == 0 ? rank[v] : 0;
+    }
+    std::fill(next.begin(), next.end(),
+              (0.85 * dangling + 0.15) / double(nv));
+    for (auto [src, dst] : pairs) {
+      next[dst] += 0.85 * rank[src] / out_degree[src];
+    }
+    std::swap(rank, next);
+  }
+  double push_secs = secs_since(start) / double(iterations);
+  std::cout << "push             " << push_secs << " s per iteration  "
+            << double(ne) / push_secs / 1e6 << " M edges/s  " << rank[0]
+            << std::endl;
+
+  for (auto &[src, dst] : pairs) {
+    std::swap(src, dst);
+  }
+  testgraph::csr in(nv, pairs);
+  std::vector<double> teleport(nv, 1.0 / double(nv));
+  unsigned max_threads = std::max(1U, std::thread::hardware_concurrency());
+  for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+    start = bench_clock::now();
+    auto result = testgraph::pagerank(in, teleport, 0.85, 0, iterations,
+                                      threads);
+    double secs = secs_since(start) / double(iterations);
+    std::cout << "pull, " << threads << " threads  " << secs
+              << " s per iteration  " << double(ne) / secs / 1e6
+              << " M edges/s  " << result.rank[0] << std::endl;
+  }
+}
@@ -0,0 +1,96 @@
+// Copyright 2020 Lawrence Livermore National Security, LLC and other CLIPPy
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+// Time to count triangles on a random undirected graph by intersecting the
+// full neighborhoods of both ends of every edge, and with the degree-ordered
+// orientation of count_triangles(); and to compute core numbers by peeling.
+//
+// usage: graph_triangles [num_nodes] [num_edges]   (default: 1000000 10000000)
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "kcore.hpp"
+#include "triangles.hpp"
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+double secs_since(bench_clock::time_point start) {
+  return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t nv = argc > 1 ? std::stoull(argv[1]) : 1000000;
+  size_t ne = argc > 2 ? std::stoull(argv[2]) : 10000000;
+
+  std::vector<std::pair<mvmap::index, mvmap::index>> pairs(ne);
+  uint64_t x = 88172645463325252ULL;
+  for (auto &[src, dst] : pairs) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    // squaring skews the degrees, as in real graphs.
+    auto r = double(x % nv) / double(nv);
+    src = mvmap::index(r * r * double(nv));
+    dst = (x >> 32) % nv;
+  }
+  testgraph::csr out(nv, pairs);
+  for (auto &[src, dst] : pairs) {
+    std::swap(src, dst);
+  }
+  testgraph::csr in(nv, pairs);
+  auto start = bench_clock::now();
+  auto g = testgraph::undirected(out, in, 1);
+  std::cout << "undirected        " << secs_since(start) << " s  "
+            << g.num_entries() / 2 << " edges" << std::endl;
+
+  start = bench_clock::now();
+  uint64_t found = 0;
+  for (mvmap::index u = 0; u < nv; ++u) {
+    auto of_u = g.neighbors(u);
+    for (auto v : of_u) {
+      auto of_v = g.neighbors(v);
+      for (auto i = of_u.begin(), j = of_v.begin();
+           i != of_u.end() && j != of_v.end();) {
+        if (*i < *j) {
+          ++i;
+        } else if (*j < *i) {
+          ++j;
+        } else {
+          ++found;
+          ++i;
+          ++j;
+        }
+      }
+    }
+  }
+  std::cout << "full intersection " << secs_since(start) << " s  "
+            << found / 6 << " triangles" << std::endl;
+
+  unsigned max_threads = std::max(1U, std::thread::hardware_concurrency());
+  for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+    start = bench_clock::now();
+    auto counts = testgraph::count_triangles(g, threads);
+    std::cout << "oriented, " << threads << " threads  " << secs_since(start)
+              << " s  " << counts.total << " triangles" << std::endl;
+  }
+  for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+    start = bench_clock::now();
+    auto cores = testgraph::core_numbers(g, threads);
+    std::cout << "kcore, " << threads << " threads  " << secs_since(start)
+              << " s  degeneracy "
+              << *std::max_element(cores.begin(), cores.end()) << std::endl;
+  }
+}
@@ -0,0 +1,74 @@
+// Copyright 2020 Lawrence Livermore National Security, LLC and other CLIPPy
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+// Time to build and to tear down a table of sparse series with the global
+// allocator, a pool, and a monotonic arena, and to forget() it instead.
+//
+// usage: mvmap_alloc [num_rows]   (default: 10000000)
+
+#include <boost/json.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory_resource>
+#include <optional>
+#include <string>
+
+#include "mvmap.hpp"
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+using table = mvmap::mvmap<uint64_t, int64_t, double>;
+
+double secs_since(bench_clock::time_point start) {
+  return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+void fill(table &t, size_t n) {
+  auto weight = t.add_series<int64_t>("weight", "",
+                                      mvmap::series_layout::sparse)
+                    .value();
+  auto score =
+      t.add_series<double>("score", "", mvmap::series_layout::sparse).value();
+  for (size_t i = 0; i < n; ++i) {
+    auto loc = weight.get_loc(i);
+    weight[loc] = int64_t(i);
+    score[loc] = double(i) * 0.5;
+  }
+}
+
+void run(const std::string &what, size_t n, std::pmr::memory_resource *mr,
+         bool forget) {
+  auto start = bench_clock::now();
+  std::optional<table> t(std::in_place, mr);
+  fill(*t, n);
+  double build = secs_since(start);
+  start = bench_clock::now();
+  if (forget) {
+    t->forget();
+  }
+  t.reset();
+  std::cout << what << "  build " << build << " s  teardown "
+            << secs_since(start) << " s" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t n = argc > 1 ? std::stoull(argv[1]) : 10000000;
+
+  run("global   ", n, std::pmr::new_delete_resource(), false);
+  {
+    std::pmr::unsynchronized_pool_resource pool;
+    run("pool     ", n, &pool, false);
+  }
+  {
+    std::pmr::monotonic_buffer_resource arena;
+    run("monotonic", n, &arena, false);
+  }
+  run("forget   ", n, std::pmr::new_delete_resource(), true);
+}
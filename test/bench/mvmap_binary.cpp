@@ -0,0 +1,100 @@
+// Copyright 2020 Lawrence Livermore National Security, LLC and other CLIPPy
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+// Time and size of saving and reloading an mvmap as JSON and in the binary
+// format.
+//
+// usage: mvmap_binary [num_rows] [dir]   (default: 1000000 /tmp)
+
+#include <boost/json.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "mvmap.hpp"
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+using table = mvmap::mvmap<std::string, bool, int64_t, double, std::string>;
+
+double secs_since(bench_clock::time_point start) {
+  return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+table make_table(size_t n) {
+  table t;
+  auto weight = t.add_series<int64_t>("weight").value();
+  auto score = t.add_series<double>("score").value();
+  auto even = t.add_series<bool>("even").value();
+  auto color = t.add_series<std::string>("color").value();
+  for (size_t i = 0; i < n; ++i) {
+    auto loc = weight.get_loc("node" + std::to_string(i));
+    weight[loc] = int64_t(i);
+    score[loc] = i * 0.5;
+    even[loc] = i % 2 == 0;
+    if (i % 4 == 0) {
+      color[loc] = "color" + std::to_string(i % 16);
+    }
+  }
+  return t;
+}
+
+void report(const std::string &what, const std::string &path, double save,
+            double load) {
+  std::cout << what << "  save " << save << " s  load " << load << " s  "
+            << std::filesystem::file_size(path) << " bytes" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t n = argc > 1 ? std::stoull(argv[1]) : 1000000;
+  std::string dir = argc > 2 ? argv[2] : "/tmp";
+  auto t = make_table(n);
+  std::cout << "n=" << n << std::endl;
+
+  std::string json_path = dir + "/mvmap_binary.json";
+  auto start = bench_clock::now();
+  {
+    std::ofstream os(json_path);
+    os << boost::json::value_from(t);
+  }
+  double save = secs_since(start);
+  start = bench_clock::now();
+  {
+    std::ifstream is(json_path);
+    std::stringstream text;
+    text << is.rdbuf();
+    auto loaded = boost::json::value_to<table>(boost::json::parse(text.str()));
+    if (loaded.size() != n) {
+      std::cerr << "JSON reload has " << loaded.size() << " rows" << std::endl;
+      return 1;
+    }
+  }
+  report("json  ", json_path, save, secs_since(start));
+
+  std::string bin_path = dir + "/mvmap_binary.bin";
+  start = bench_clock::now();
+  t.save_binary(bin_path);
+  save = secs_since(start);
+  start = bench_clock::now();
+  auto loaded = table::load_binary(bin_path);
+  double load = secs_since(start);
+  if (loaded.size() != n) {
+    std::cerr << "binary reload has " << loaded.size() << " rows" << std::endl;
+    return 1;
+  }
+  report("binary", bin_path, save, load);
+
+  std::filesystem::remove(json_path);
+  std::filesystem::remove(bin_path);
+  return 0;
+}
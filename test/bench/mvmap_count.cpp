@@ -0,0 +1,65 @@
+// Copyright 2020 Lawrence Livermore National Security, LLC and other CLIPPy
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+// Time to count the values of a series into an ordered map, as count() used
+// to, and into hash tables on 1, 2, 4, ... threads, with and without top-k.
+//
+// usage: mvmap_count [num_rows] [num_distinct]   (default: 10000000 1000000)
+
+#include <boost/json.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+
+#include "mvmap.hpp"
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+using table = mvmap::mvmap<uint64_t, int64_t>;
+
+double secs_since(bench_clock::time_point start) {
+  return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t n = argc > 1 ? std::stoull(argv[1]) : 10000000;
+  size_t distinct = argc > 2 ? std::stoull(argv[2]) : 1000000;
+
+  table t;
+  auto val = t.add_series<int64_t>("val").value();
+  uint64_t x = 88172645463325252ULL;
+  for (size_t i = 0; i < n; ++i) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    val[val.get_loc(i)] = int64_t(x % distinct);
+  }
+
+  auto start = bench_clock::now();
+  std::map<int64_t, size_t> ordered;
+  val.for_all([&ordered](auto, auto, int64_t v) { ordered[v]++; });
+  std::cout << "std::map            " << secs_since(start) << " s  "
+            << ordered.size() << " values" << std::endl;
+
+  unsigned max_threads = std::max(1U, std::thread::hardware_concurrency());
+  for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+    start = bench_clock::now();
+    auto counts = val.value_counts(threads);
+    double count_secs = secs_since(start);
+    start = bench_clock::now();
+    auto top = mvmap::top_counts(counts, 10);
+    std::cout << "hash, " << threads << " threads  " << count_secs
+              << " s  top-10 " << secs_since(start) << " s  "
+              << counts.size() << " values, most frequent " << top[0].first
+              << " x" << top[0].second << std::endl;
+  }
+}
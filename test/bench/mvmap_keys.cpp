@@ -0,0 +1,144 @@
+// Copyright 2020 Lawrence Livermore National Security, LLC and other CLIPPy
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+// Insert and lookup throughput of mvmap's key dictionary, against the pair
+// of std::maps it replaced.
+//
+// usage: mvmap_keys [num_keys ...]   (default: 1000000 10000000 100000000)
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "mvmap.hpp"
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+// the std::map baseline gets slow and large well before the hash table does.
+constexpr size_t max_baseline_keys = 10000000;
+
+double ns_per_op(bench_clock::time_point start, size_t ops) {
+  return std::chrono::duration<double, std::nano>(bench_clock::now() - start)
+             .count() /
+         ops;
+}
+
+void report(const std::string &what, size_t n, double insert_ns,
+            double hit_ns, double miss_ns) {
+  std::cout << what << " n=" << n << "  insert " << insert_ns
+            << " ns  hit " << hit_ns << " ns  miss " << miss_ns << " ns"
+            << std::endl;
+}
+
+void bench_dictionary(const std::vector<std::string> &keys,
+                      const std::vector<size_t> &probe_order,
+                      const std::vector<std::string> &misses) {
+  mvmap::key_dictionary<std::string> dict;
+  auto start = bench_clock::now();
+  for (const auto &k : keys) {
+    dict.insert(k);
+  }
+  double insert_ns = ns_per_op(start, keys.size());
+
+  size_t found = 0;
+  start = bench_clock::now();
+  for (auto i : probe_order) {
+    found += dict.find(keys[i]).has_value();
+  }
+  double hit_ns = ns_per_op(start, probe_order.size());
+
+  start = bench_clock::now();
+  for (const auto &k : misses) {
+    found += dict.find(k).has_value();
+  }
+  double miss_ns = ns_per_op(start, misses.size());
+
+  if (found != keys.size()) {
+    std::cerr << "key_dictionary lookups are wrong" << std::endl;
+    std::exit(1);
+  }
+  report("key_dictionary", keys.size(), insert_ns, hit_ns, miss_ns);
+}
+
+void bench_std_map(const std::vector<std::string> &keys,
+                   const std::vector<size_t> &probe_order,
+                   const std::vector<std::string> &misses) {
+  std::map<std::string, mvmap::index> kti;
+  std::map<mvmap::index, std::string> itk;
+  auto start = bench_clock::now();
+  for (const auto &k : keys) {
+    if (!kti.contains(k)) {
+      mvmap::index i = kti.size();
+      kti[k] = i;
+      itk[i] = k;
+    }
+  }
+  double insert_ns = ns_per_op(start, keys.size());
+
+  size_t found = 0;
+  start = bench_clock::now();
+  for (auto i : probe_order) {
+    found += kti.contains(keys[i]);
+  }
+  double hit_ns = ns_per_op(start, probe_order.size());
+
+  start = bench_clock::now();
+  for (const auto &k : misses) {
+    found += kti.contains(k);
+  }
+  double miss_ns = ns_per_op(start, misses.size());
+
+  if (found != keys.size()) {
+    std::cerr << "std::map lookups are wrong" << std::endl;
+    std::exit(1);
+  }
+  report("std::map      ", keys.size(), insert_ns, hit_ns, miss_ns);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  std::vector<size_t> sizes;
+  for (int i = 1; i < argc; ++i) {
+    sizes.push_back(std::stoull(argv[i]));
+  }
+  if (sizes.empty()) {
+    sizes = {1000000, 10000000, 100000000};
+  }
+
+  std::mt19937_64 rng(42);
+  for (auto n : sizes) {
+    // node names like the ones testgraph stores.
+    std::vector<std::string> keys(n);
+    for (size_t i = 0; i < n; ++i) {
+      keys[i] = "node" + std::to_string(i);
+    }
+    std::shuffle(keys.begin(), keys.end(), rng);
+
+    std::vector<size_t> probe_order(n);
+    std::iota(probe_order.begin(), probe_order.end(), 0);
+    std::shuffle(probe_order.begin(), probe_order.end(), rng);
+
+    std::vector<std::string> misses(std::min<size_t>(n, 1000000));
+    for (size_t i = 0; i < misses.size(); ++i) {
+      misses[i] = "edge" + std::to_string(i);
+    }
+
+    bench_dictionary(keys, probe_order, misses);
+    if (n <= max_baseline_keys) {
+      bench_std_map(keys, probe_order, misses);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,64 @@
+// Copyright 2020 Lawrence Livermore National Security, LLC and other CLIPPy
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+// Time to remove half the rows of an mvmap with remove_if, with and without
+// renumbering the remaining rows.
+//
+// usage: mvmap_remove [num_rows]   (default: 10000000)
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "mvmap.hpp"
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+using table = mvmap::mvmap<std::string, bool, int64_t, double, std::string>;
+
+table make_table(size_t n) {
+  table t;
+  auto weight = t.add_series<int64_t>("weight").value();
+  auto score = t.add_series<double>("score").value();
+  for (size_t i = 0; i < n; ++i) {
+    auto loc = weight.get_loc("node" + std::to_string(i));
+    weight[loc] = int64_t(i);
+    score[loc] = i * 0.5;
+  }
+  return t;
+}
+
+void bench_remove(size_t n, bool renumber) {
+  auto t = make_table(n);
+  auto weight = t.get_series<int64_t>("weight").value();
+
+  auto start = bench_clock::now();
+  t.remove_if(
+      [&weight](const auto & /*unused*/, auto loc) {
+        return weight[loc] % 2 == 0;
+      },
+      renumber);
+  double secs =
+      std::chrono::duration<double>(bench_clock::now() - start).count();
+
+  if (t.size() != n / 2) {
+    std::cerr << "remove_if kept " << t.size() << " rows" << std::endl;
+    std::exit(1);
+  }
+  std::cout << "remove_if n=" << n << (renumber ? " renumbered" : "") << "  "
+            << secs << " s" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t n = argc > 1 ? std::stoull(argv[1]) : 10000000;
+  bench_remove(n, false);
+  bench_remove(n, true);
+  return 0;
+}
@@ -0,0 +1,342 @@
+#pragma once
+// Building blocks for mvmap's binary format: little-endian, 8-byte aligned
+// sections written to a stream, and read back from a memory buffer, usually
+// a memory-mapped file.
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mvmap::binary {
+
+// identifies the type of an array, so that a reader can check it against the
+// type it expects.
+struct type_code {
+  char kind;  // 'b'ool, 'i'nt, 'u'nsigned, 'f'loat, 's'tring, 'p'air
+  uint8_t width;
+
+  bool operator==(const type_code &) const = default;
+};
+
+template <typename T>
+struct is_pair : std::false_type {};
+template <typename A, typename B>
+struct is_pair<std::pair<A, B>> : std::true_type {};
+
+// true if values of type T are, or contain, strings.
+template <typename T>
+constexpr bool has_strings() {
+  if constexpr (is_pair<T>::value) {
+    return has_strings<typename T::first_type>() ||
+           has_strings<typename T::second_type>();
+  } else {
+    return std::is_same_v<T, std::string>;
+  }
+}
+
+template <typename T>
+constexpr type_code code_of() {
+  if constexpr (std::is_same_v<T, bool>) {
+    return {'b', 1};
+  } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+    return {'i', sizeof(T)};
+  } else if constexpr (std::is_integral_v<T>) {
+    return {'u', sizeof(T)};
+  } else if constexpr (std::is_floating_point_v<T>) {
+    return {'f', sizeof(T)};
+  } else if constexpr (std::is_same_v<T, std::string>) {
+    return {'s', sizeof(uint32_t)};
+  } else {
+    static_assert(is_pair<T>::value, "no binary encoding for this type");
+    return {'p', 0};
+  }
+}
+
+// the unsigned integer with the same size as an arithmetic T.
+template <typename T>
+using bits_of = std::conditional_t<
+    sizeof(T) == 8, uint64_t,
+    std::conditional_t<sizeof(T) == 4, uint32_t,
+                       std::conditional_t<sizeof(T) == 2, uint16_t, uint8_t>>>;
+
+template <typename U>
+U byteswap(U u) {
+  U swapped = 0;
+  for (size_t b = 0; b < sizeof(U); ++b) {
+    swapped = (swapped << 8) | ((u >> (8 * b)) & 0xff);
+  }
+  return swapped;
+}
+
+// converts between native and little-endian representations.
+template <typename T>
+T little_endian(T v) {
+  if constexpr (std::endian::native == std::endian::little || sizeof(T) == 1) {
+    return v;
+  } else {
+    return std::bit_cast<T>(byteswap(std::bit_cast<bits_of<T>>(v)));
+  }
+}
+
+// writes little-endian values to a stream, through a buffer, keeping track
+// of the offset so that sections can be padded to 8 bytes. Call flush() when
+// done.
+class writer {
+  static constexpr size_t buffer_size = size_t{1} << 16;
+
+  std::ostream &os;
+  std::vector<char> buffer;
+  uint64_t offset = 0;
+
+ public:
+  explicit writer(std::ostream &os) : os(os) { buffer.reserve(buffer_size); }
+
+  void bytes(const void *p, size_t n) {
+    const auto *c = static_cast<const char *>(p);
+    if (buffer.size() + n > buffer_size) {
+      flush();
+      if (n > buffer_size) {
+        os.write(c, std::streamsize(n));
+        offset += n;
+        return;
+      }
+    }
+    buffer.insert(buffer.end(), c, c + n);
+    offset += n;
+  }
+
+  void flush() {
+    os.write(buffer.data(), std::streamsize(buffer.size()));
+    buffer.clear();
+  }
+
+  template <typename T>
+  void scalar(T v) {
+    v = little_endian(v);
+    bytes(&v, sizeof(v));
+  }
+
+  template <typename T>
+  void array(const std::vector<T> &vs) {
+    if constexpr (std::endian::native == std::endian::little) {
+      bytes(vs.data(), vs.size() * sizeof(T));
+    } else {
+      for (auto v : vs) {
+        scalar(v);
+      }
+    }
+  }
+
+  void align() {
+    static constexpr char zeros[8] = {};
+    bytes(zeros, (8 - offset % 8) % 8);
+  }
+
+  // u64 count, u64 offsets[count + 1], then the bytes of every string.
+  template <typename Strings>
+  void strings(const Strings &all) {
+    scalar(uint64_t(std::ranges::distance(all)));
+    uint64_t pos = 0;
+    scalar(pos);
+    for (auto s : all) {
+      pos += s.size();
+      scalar(pos);
+    }
+    for (auto s : all) {
+      bytes(s.data(), s.size());
+    }
+    align();
+  }
+
+  // writes n values of type T, produced by for_each(f), which calls f on
+  // each value in turn; pairs are written as two arrays, so for_each may be
+  // called more than once. Strings are written as their table.id(), and
+  // bools are packed 64 to a word.
+  template <typename T, typename Table, typename ForEach>
+  void values(const Table &table, size_t n, ForEach for_each) {
+    if constexpr (is_pair<T>::value) {
+      values<typename T::first_type>(table, n, [&for_each](auto f) {
+        for_each([&f](const T &v) { f(v.first); });
+      });
+      values<typename T::second_type>(table, n, [&for_each](auto f) {
+        for_each([&f](const T &v) { f(v.second); });
+      });
+      return;
+    } else if constexpr (std::is_same_v<T, bool>) {
+      uint64_t word = 0;
+      size_t i = 0;
+      for_each([this, &word, &i](bool v) {
+        word |= uint64_t{v} << (i % 64);
+        if (++i % 64 == 0) {
+          scalar(word);
+          word = 0;
+        }
+      });
+      if (i % 64 != 0) {
+        scalar(word);
+      }
+    } else if constexpr (std::is_same_v<T, std::string>) {
+      for_each([this, &table](const std::string &v) { scalar(table.id(v)); });
+    } else {
+      for_each([this](T v) { scalar(v); });
+    }
+    align();
+  }
+};
+
+// reads what a writer wrote from a buffer. Throws std::runtime_error if the
+// buffer is too short.
+class reader {
+  std::span<const std::byte> buf;
+  size_t pos = 0;
+
+  const std::byte *take(size_t n) {
+    if (n > buf.size() - pos) {
+      throw std::runtime_error("truncated binary data");
+    }
+    const auto *p = buf.data() + pos;
+    pos += n;
+    return p;
+  }
+
+ public:
+  explicit reader(std::span<const std::byte> buf) : buf(buf) {}
+
+  [[nodiscard]] size_t offset() const { return pos; }
+  [[nodiscard]] bool at_end() const { return pos == buf.size(); }
+
+  std::string_view bytes(size_t n) {
+    return {reinterpret_cast<const char *>(take(n)), n};
+  }
+
+  template <typename T>
+  T scalar() {
+    T v;
+    std::memcpy(&v, take(sizeof(T)), sizeof(T));
+    return little_endian(v);
+  }
+
+  template <typename T>
+  std::vector<T> array(size_t n) {
+    if (n > (buf.size() - pos) / sizeof(T)) {
+      throw std::runtime_error("truncated binary data");
+    }
+    std::vector<T> vs(n);
+    if (n > 0) {
+      std::memcpy(vs.data(), take(n * sizeof(T)), n * sizeof(T));
+    }
+    if constexpr (std::endian::native != std::endian::little) {
+      for (auto &v : vs) {
+        v = little_endian(v);
+      }
+    }
+    return vs;
+  }
+
+  void align() { take((8 - pos % 8) % 8); }
+
+  // the strings point into the buffer.
+  std::vector<std::string_view> strings() {
+    auto n = scalar<uint64_t>();
+    auto offsets = array<uint64_t>(n + 1);
+    auto blob = bytes(offsets.back());
+    std::vector<std::string_view> all;
+    all.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+      if (offsets[i] > offsets[i + 1] || offsets[i + 1] > blob.size()) {
+        throw std::runtime_error("corrupt string table");
+      }
+      all.push_back(blob.substr(offsets[i], offsets[i + 1] - offsets[i]));
+    }
+    align();
+    return all;
+  }
+
+  template <typename T>
+  std::vector<T> values(const std::vector<std::string_view> &strings,
+                        size_t n) {
+    std::vector<T> vs;
+    if constexpr (is_pair<T>::value) {
+      auto firsts = values<typename T::first_type>(strings, n);
+      auto seconds = values<typename T::second_type>(strings, n);
+      vs.reserve(n);
+      for (size_t i = 0; i < n; ++i) {
+        vs.emplace_back(std::move(firsts[i]), std::move(seconds[i]));
+      }
+      return vs;
+    } else if constexpr (std::is_same_v<T, bool>) {
+      auto words = array<uint64_t>((n + 63) / 64);
+      vs.resize(n);
+      for (size_t i = 0; i < n; ++i) {
+        vs[i] = ((words[i / 64] >> (i % 64)) & 1) != 0;
+      }
+    } else if constexpr (std::is_same_v<T, std::string>) {
+      auto ids = array<uint32_t>(n);
+      vs.reserve(n);
+      for (auto id : ids) {
+        if (id >= strings.size()) {
+          throw std::runtime_error("corrupt string id");
+        }
+        vs.emplace_back(strings[id]);
+      }
+    } else {
+      vs = array<T>(n);
+    }
+    align();
+    return vs;
+  }
+};
+
+// A read-only memory mapping of a whole file.
+class mapped_file {
+  void *addr = nullptr;
+  size_t len = 0;
+
+ public:
+  explicit mapped_file(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("cannot open " + path);
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) {
+      ::close(fd);
+      throw std::runtime_error("cannot stat " + path);
+    }
+    len = size_t(st.st_size);
+    if (len > 0) {
+      addr = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+      throw std::runtime_error("cannot map " + path);
+    }
+  }
+  mapped_file(const mapped_file &) = delete;
+  mapped_file &operator=(const mapped_file &) = delete;
+  ~mapped_file() {
+    if (addr != nullptr) {
+      ::munmap(addr, len);
+    }
+  }
+
+  [[nodiscard]] std::span<const std::byte> bytes() const {
+    return {static_cast<const std::byte *>(addr), len};
+  }
+};
+
+}  // namespace mvmap::binary
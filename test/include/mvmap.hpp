@@ -2,17 +2,33 @@
 #include <boost/json.hpp>
 // #include <boost/json/conversion.hpp>
 #include <boost/json/src.hpp>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <concepts>
 #include <cstdint>
+#include <fstream>
+#include <functional>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <memory_resource>
 #include <optional>
 #include <ranges>
 #include <set>
+#include <span>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
 #include <utility>
 #include <variant>
 #include <vector>
 
+#include "binary_io.hpp"
+
 template <typename T1, typename T2>
 std::ostream &operator<<(std::ostream &os, const std::pair<T1, T2> &p) {
   os << "(" << p.first << ", " << p.second << ")";
@@ -30,6 +46,7 @@ class locator {
  public:
   template <typename K, typename... Vs>
   friend class mvmap;
+  friend class selection;
   friend std::ostream &operator<<(std::ostream &os, const locator &l) {
     if (l.is_valid()) {
       os << "locator: " << l.loc;
@@ -53,21 +70,1892 @@ class locator {
     }
   }
 };
-void tag_invoke(boost::json::value_from_tag /*unused*/, boost::json::value &v,
-                locator l) {
-  v = l.loc;
-}
-
-locator tag_invoke(boost::json::value_to_tag<locator> /*unused*/,
-                   const boost::json::value &v) {
-  return boost::json::value_to<index>(v);
-}
+void tag_invoke(boost::json::value_from_tag /*unused*/, boost::json::value &v,
+                locator l) {
+  v = l.loc;
+}
+
+locator tag_invoke(boost::json::value_to_tag<locator> /*unused*/,
+                   const boost::json::value &v) {
+  return boost::json::value_to<index>(v);
+}
+
+// A selection is a set of locators in an mvmap, stored as a bitmap over
+// indices.
+class selection {
+  std::vector<uint64_t> bits;
+
+ public:
+  selection() = default;
+  explicit selection(size_t capacity) : bits((capacity + 63) / 64, 0) {}
+  explicit selection(const std::vector<index> &indices) {
+    for (auto i : indices) {
+      insert(i);
+    }
+  }
+
+  // the selection whose bitmap is words, as returned by words().
+  static selection from_words(std::vector<uint64_t> words) {
+    selection s;
+    s.bits = std::move(words);
+    return s;
+  }
+
+  void insert(index i) {
+    if (i / 64 >= bits.size()) {
+      bits.resize(i / 64 + 1, 0);
+    }
+    bits[i / 64] |= uint64_t{1} << (i % 64);
+  }
+  void insert(const locator &l) { insert(l.loc); }
+
+  [[nodiscard]] bool contains(const locator &l) const {
+    return contains(l.loc);
+  }
+  [[nodiscard]] bool contains(index i) const {
+    return i / 64 < bits.size() && ((bits[i / 64] >> (i % 64)) & 1) != 0;
+  }
+
+  // the bitmap, 64 indices per word.
+  [[nodiscard]] const std::vector<uint64_t> &words() const { return bits; }
+
+  [[nodiscard]] size_t count() const {
+    size_t ct = 0;
+    for (auto word : bits) {
+      ct += std::popcount(word);
+    }
+    return ct;
+  }
+
+  [[nodiscard]] std::vector<index> indices() const {
+    std::vector<index> result;
+    for (size_t w = 0; w < bits.size(); ++w) {
+      for (auto word = bits[w]; word != 0; word &= word - 1) {
+        result.push_back(w * 64 + std::countr_zero(word));
+      }
+    }
+    return result;
+  }
+};
+
+// how a column stores its cells.
+enum class series_layout {
+  automatic,  // dense or sparse, chosen by fill ratio
+  sparse,
+  dense
+};
+
+// how a column stores its values.
+enum class series_encoding {
+  plain,      // each cell holds its value
+  dictionary  // each distinct value is stored once; cells hold a code for it
+};
+
+// hashes keys and values; std::hash has no pair overload.
+template <typename K>
+struct key_hash {
+  size_t operator()(const K &k) const { return std::hash<K>{}(k); }
+};
+
+template <typename A, typename B>
+struct key_hash<std::pair<A, B>> {
+  size_t operator()(const std::pair<A, B> &k) const {
+    size_t h = key_hash<A>{}(k.first);
+    return h ^ (key_hash<B>{}(k.second) + 0x9e3779b97f4a7c15 + (h << 6) +
+                (h >> 2));
+  }
+};
+
+// the splitmix64 finalizer, which spreads every input bit over the output.
+inline uint64_t mix_bits(uint64_t h) {
+  h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9;
+  h = (h ^ (h >> 27)) * 0x94d049bb133111eb;
+  return h ^ (h >> 31);
+}
+
+// Running statistics of a column: the number of values, their sum (for
+// arithmetic types; bools sum to the number of trues), the minimum and
+// maximum with an index holding each, and an approximate number of distinct
+// values (a HyperLogLog sketch, within a few percent). Each write and erase
+// updates them in O(1). Erasing the current minimum or maximum, or raising
+// (lowering) it in place, makes the extrema stale; removing or overwriting
+// any value makes the distinct count stale, since the sketch can't forget
+// values. The column recomputes stale statistics with one scan the next
+// time they are read.
+template <typename V>
+class series_stats {
+ public:
+  using sum_type = std::conditional_t<
+      std::is_floating_point_v<V>, double,
+      std::conditional_t<std::is_integral_v<V>, int64_t, std::monostate>>;
+
+ private:
+  static constexpr size_t sketch_bits = 10;
+  static constexpr size_t sketch_size = size_t{1} << sketch_bits;
+  static constexpr bool has_sum = !std::is_same_v<sum_type, std::monostate>;
+
+  size_t num_values = 0;
+  sum_type total{};
+  std::optional<std::pair<V, index>> lo;
+  std::optional<std::pair<V, index>> hi;
+  std::array<uint8_t, sketch_size> sketch{};
+  bool extrema_stale = false;
+  bool sketch_stale = false;
+
+  // a write handed out by reference, to be folded in once the value is
+  // stored: the index written to and the value it held before.
+  std::optional<index> pending_idx;
+  std::optional<V> pending_old;
+
+  void observe(const V &v) {
+    uint64_t h = mix_bits(key_hash<V>{}(v));
+    size_t reg = h >> (64 - sketch_bits);
+    auto rank = uint8_t(std::countl_zero((h << sketch_bits) | 1) + 1);
+    sketch[reg] = std::max(sketch[reg], rank);
+  }
+
+  // the value at i changes from old to v.
+  void replace(const V &old, const V &v, index i) {
+    if constexpr (has_sum) {
+      total += sum_type(v) - sum_type(old);
+    }
+    if (lo && lo->second == i) {
+      extrema_stale = extrema_stale || old < v;
+      lo->first = v;
+    } else if (lo && v < lo->first) {
+      lo = {v, i};
+    }
+    if (hi && hi->second == i) {
+      extrema_stale = extrema_stale || v < old;
+      hi->first = v;
+    } else if (hi && hi->first < v) {
+      hi = {v, i};
+    }
+    observe(v);
+    sketch_stale = true;
+  }
+
+ public:
+  [[nodiscard]] size_t count() const { return num_values; }
+  [[nodiscard]] sum_type sum() const { return total; }
+  [[nodiscard]] const std::optional<std::pair<V, index>> &min() const {
+    return lo;
+  }
+  [[nodiscard]] const std::optional<std::pair<V, index>> &max() const {
+    return hi;
+  }
+
+  [[nodiscard]] double distinct() const {
+    double m = sketch_size;
+    double inv_sum = 0;
+    size_t zeros = 0;
+    for (auto r : sketch) {
+      inv_sum += std::ldexp(1.0, -int(r));
+      zeros += r == 0 ? 1 : 0;
+    }
+    double estimate = 0.7213 / (1 + 1.079 / m) * m * m / inv_sum;
+    if (estimate <= 2.5 * m && zeros > 0) {
+      estimate = m * std::log(m / double(zeros));
+    }
+    return std::min(estimate, double(num_values));
+  }
+
+  // whether the extrema, or the distinct count, must be recomputed before
+  // they are read.
+  [[nodiscard]] bool stale_extrema() const { return extrema_stale; }
+  [[nodiscard]] bool stale_distinct() const { return sketch_stale; }
+
+  void add(const V &v, index i) {
+    ++num_values;
+    if constexpr (has_sum) {
+      total += sum_type(v);
+    }
+    if (!lo || v < lo->first) {
+      lo = {v, i};
+    }
+    if (!hi || hi->first < v) {
+      hi = {v, i};
+    }
+    observe(v);
+  }
+
+  void remove(const V &v, index i) {
+    --num_values;
+    if constexpr (has_sum) {
+      total -= sum_type(v);
+    }
+    if ((lo && lo->second == i) || (hi && hi->second == i)) {
+      extrema_stale = true;
+    }
+    sketch_stale = true;
+  }
+
+  // records that the cell at i, which held old (if anything), is about to
+  // be written through a reference.
+  void begin_write(index i, std::optional<V> old) {
+    pending_idx = i;
+    pending_old = std::move(old);
+  }
+  [[nodiscard]] const std::optional<index> &pending() const {
+    return pending_idx;
+  }
+
+  // folds in the pending write, now that the cell holds v.
+  void end_write(const V &v) {
+    auto i = *pending_idx;
+    pending_idx.reset();
+    if (!pending_old) {
+      add(v, i);
+    } else if (!(*pending_old == v)) {
+      replace(*pending_old, v, i);
+    }
+    pending_old.reset();
+  }
+
+  // moves the recorded minimum and maximum along with their cells. A stale
+  // extremum may be at an index that no longer exists.
+  void renumber(const std::vector<index> &new_index) {
+    for (auto *ext : {&lo, &hi}) {
+      if (!*ext) {
+        continue;
+      }
+      auto i = (*ext)->second;
+      if (i < new_index.size() &&
+          new_index[i] != std::numeric_limits<index>::max()) {
+        (*ext)->second = new_index[i];
+      } else {
+        extrema_stale = true;
+      }
+    }
+  }
+};
+
+// the heap memory a value owns: the buffer of a string too long to be stored
+// inside the string object itself.
+template <typename T>
+size_t heap_bytes(const T &v) {
+  if constexpr (std::is_same_v<T, std::string>) {
+    const auto *obj = reinterpret_cast<const char *>(&v);
+    return v.data() < obj || v.data() >= obj + sizeof(v) ? v.capacity() + 1
+                                                         : 0;
+  } else if constexpr (binary::is_pair<T>::value) {
+    return heap_bytes(v.first) + heap_bytes(v.second);
+  } else {
+    return 0;
+  }
+}
+
+template <typename K>
+class key_dictionary;
+template <typename V>
+struct encoded_column;
+
+// A column_storage holds the values of a series, by index. It is stored
+// either sparsely, as a map from index to value, or densely, as a vector
+// indexed by index with a validity bitmap marking which cells hold a value.
+// Both representations present the same map-like interface, iterating over
+// (index, value) pairs in index order. All of the column's memory comes from
+// one memory resource, which copies of the column share; the values' own
+// heap buffers (those of strings) still come from the global allocator.
+//
+// A dictionary-encoded column instead keeps each distinct value once, and a
+// column of integer codes in either representation; see encoded_cells.
+template <typename V>
+class column_storage {
+  using cell_map = std::pmr::map<index, V>;
+
+  // wraps the value so that a dense column of bools is not a vector<bool>
+  // and can hand out references.
+  struct cell {
+    V value{};
+  };
+
+  // an automatic column goes dense when at least dense_fill of the cells up
+  // to its largest index hold a value, and back to sparse below sparse_fill.
+  static constexpr size_t dense_fill_inv = 2;
+  static constexpr size_t sparse_fill_inv = 8;
+
+  // indexed by series_layout.
+  static constexpr std::array<std::string_view, 3> layout_names{
+      "automatic", "sparse", "dense"};
+
+  series_layout mode = series_layout::automatic;
+  bool is_dense = false;
+
+  cell_map cells;
+
+  std::pmr::vector<cell> values;
+  std::pmr::vector<uint64_t> valid;
+  size_t num_valid = 0;
+
+  // the column's statistics, if it tracks them. Reading them brings them up
+  // to date, which doesn't change the column's contents.
+  mutable std::optional<series_stats<V>> stats;
+
+  using encoded_cells = encoded_column<V>;
+
+  // set if the column is dictionary-encoded, in which case the plain cells
+  // are empty.
+  std::unique_ptr<encoded_cells> enc;
+
+  [[nodiscard]] bool is_valid(index i) const {
+    return i < values.size() && ((valid[i / 64] >> (i % 64)) & 1) != 0;
+  }
+
+  // returns the first valid index at or after i, or values.size().
+  [[nodiscard]] index next_valid(index i) const {
+    if (i >= values.size()) {
+      return values.size();
+    }
+    size_t w = i / 64;
+    uint64_t word = valid[w] & (~uint64_t{0} << (i % 64));
+    while (word == 0) {
+      if (++w == valid.size()) {
+        return values.size();
+      }
+      word = valid[w];
+    }
+    return w * 64 + std::countr_zero(word);
+  }
+
+  [[nodiscard]] size_t span() const {
+    if (is_dense) {
+      return values.size();
+    }
+    return cells.empty() ? 0 : cells.rbegin()->first + 1;
+  }
+
+  void to_dense() {
+    std::pmr::vector<cell> vals(span(), resource());
+    std::pmr::vector<uint64_t> bits((vals.size() + 63) / 64, 0, resource());
+    for (auto &[i, v] : cells) {
+      vals[i].value = std::move(v);
+      bits[i / 64] |= uint64_t{1} << (i % 64);
+    }
+    num_valid = cells.size();
+    values = std::move(vals);
+    valid = std::move(bits);
+    cells.clear();
+    is_dense = true;
+  }
+
+  void to_sparse() {
+    cell_map sparse(resource());
+    for (index i = next_valid(0); i < values.size(); i = next_valid(i + 1)) {
+      sparse.emplace_hint(sparse.end(), i, std::move(values[i].value));
+    }
+    cells = std::move(sparse);
+    values.clear();
+    values.shrink_to_fit();
+    valid.clear();
+    valid.shrink_to_fit();
+    num_valid = 0;
+    is_dense = false;
+  }
+
+  // returns the code of v, adding it to the dictionary if it is new.
+  uint32_t encode(const V &v) const {
+    auto code = enc->dict.insert(v).first;
+    if (code >= encoded_cells::unsettled) {
+      throw std::runtime_error("too many distinct values to encode");
+    }
+    return uint32_t(code);
+  }
+
+  // encodes the writes handed out by operator[] into their cells.
+  void settle_code() const {
+    if (!enc || enc->pending.empty()) {
+      return;
+    }
+    for (const auto &[i, v] : enc->pending) {
+      enc->codes[i] = encode(v);
+    }
+    enc->pending.clear();
+  }
+
+  // the value at i, or nullptr if there is none. Unlike find(), this sees
+  // the writes to an encoded column without encoding them.
+  const V *peek(index i) const {
+    if (!enc) {
+      auto it = find(i);
+      return it == end() ? nullptr : &it->second;
+    }
+    if (auto p = enc->pending.find(i); p != enc->pending.end()) {
+      return &p->second;
+    }
+    const auto &codes = enc->codes;
+    auto it = codes.find(i);
+    return it == codes.end() ? nullptr : &enc->dict.key_at((*it).second);
+  }
+
+  // assumes an encoded column with a value at i.
+  const V &decoded(index i) const {
+    settle_code();
+    return enc->dict.key_at((*std::as_const(enc->codes).find(i)).second);
+  }
+
+  // the first index at or after i with a value in an encoded column, or its
+  // extent.
+  [[nodiscard]] index next_code(index i) const {
+    const auto &codes = enc->codes;
+    auto it = codes.lower_bound(i);
+    return it == codes.end() ? codes.extent() : (*it).first;
+  }
+
+  // empties the plain cells and releases their memory.
+  void drop_cells() {
+    cells.clear();
+    values.clear();
+    values.shrink_to_fit();
+    valid.clear();
+    valid.shrink_to_fit();
+    num_valid = 0;
+  }
+
+  // folds the last write handed out by operator[] into the statistics.
+  void settle_stats() const {
+    if (stats && stats->pending()) {
+      stats->end_write(*peek(*stats->pending()));
+    }
+  }
+
+  void settle() const {
+    settle_stats();
+    settle_code();
+  }
+
+  void rescan() const {
+    series_stats<V> fresh;
+    for (const auto &[i, v] : *this) {
+      fresh.add(v, i);
+    }
+    *stats = std::move(fresh);
+  }
+
+  // switches an automatic column to the representation its fill ratio calls
+  // for.
+  void adapt() {
+    if (mode != series_layout::automatic) {
+      return;
+    }
+    if (!is_dense && cells.size() * dense_fill_inv >= span()) {
+      to_dense();
+    } else if (is_dense && num_valid * sparse_fill_inv < span()) {
+      to_sparse();
+    }
+  }
+
+  template <bool Const>
+  class iter {
+    using column_type =
+        std::conditional_t<Const, const column_storage, column_storage>;
+    using map_iter =
+        std::conditional_t<Const, typename cell_map::const_iterator,
+                           typename cell_map::iterator>;
+
+    column_type *col = nullptr;
+    map_iter it;
+    index pos = 0;
+
+    friend class column_storage;
+    iter(column_type *col, map_iter it, index pos)
+        : col(col), it(it), pos(pos) {}
+
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = std::pair<index, V>;
+    using reference =
+        std::pair<const index, std::conditional_t<Const, const V &, V &>>;
+    struct pointer {
+      reference ref;
+      const reference *operator->() const { return &ref; }
+    };
+
+    iter() = default;
+
+    // a writable reference into an encoded column comes from operator[].
+    reference operator*() const {
+      if (col->enc) {
+        if constexpr (Const) {
+          return {pos, col->decoded(pos)};
+        } else {
+          return {pos, (*col)[pos]};
+        }
+      }
+      if (col->is_dense) {
+        return {pos, col->values[pos].value};
+      }
+      return {it->first, it->second};
+    }
+    pointer operator->() const { return {**this}; }
+
+    iter &operator++() {
+      if (col->enc) {
+        pos = col->next_code(pos + 1);
+      } else if (col->is_dense) {
+        pos = col->next_valid(pos + 1);
+      } else {
+        ++it;
+      }
+      return *this;
+    }
+    iter operator++(int) {
+      auto old = *this;
+      ++*this;
+      return old;
+    }
+
+    bool operator==(const iter &other) const {
+      return col->enc || col->is_dense ? pos == other.pos : it == other.it;
+    }
+  };
+
+ public:
+  using key_type = index;
+  using mapped_type = V;
+  using iterator = iter<false>;
+  using const_iterator = iter<true>;
+
+  column_storage() = default;
+  explicit column_storage(
+      series_layout mode,
+      std::pmr::memory_resource *mr = std::pmr::get_default_resource())
+      : cells(mr), values(mr), valid(mr) {
+    set_layout(mode);
+  }
+
+  // a copy allocates from the same memory resource as the original.
+  column_storage(const column_storage &other)
+      : mode(other.mode),
+        is_dense(other.is_dense),
+        cells(other.cells, other.resource()),
+        values(other.values, other.resource()),
+        valid(other.valid, other.resource()),
+        num_valid(other.num_valid),
+        stats(other.stats),
+        enc(other.enc ? std::make_unique<encoded_cells>(*other.enc)
+                      : nullptr) {}
+  column_storage(column_storage &&) noexcept = default;
+  column_storage &operator=(const column_storage &other) {
+    if (this != &other) {
+      *this = column_storage(other);
+    }
+    return *this;
+  }
+  column_storage &operator=(column_storage &&) = default;
+  ~column_storage() = default;
+
+  [[nodiscard]] std::pmr::memory_resource *resource() const {
+    return cells.get_allocator().resource();
+  }
+
+  [[nodiscard]] series_layout layout() const { return mode; }
+  [[nodiscard]] bool dense() const {
+    return enc ? enc->codes.dense() : is_dense;
+  }
+
+  void set_layout(series_layout new_mode) {
+    mode = new_mode;
+    if (enc) {
+      enc->codes.set_layout(mode);
+    } else if (mode == series_layout::dense && !is_dense) {
+      to_dense();
+    } else if (mode == series_layout::sparse && is_dense) {
+      to_sparse();
+    } else {
+      adapt();
+    }
+  }
+
+  [[nodiscard]] series_encoding encoding() const {
+    return enc ? series_encoding::dictionary : series_encoding::plain;
+  }
+
+  // re-encodes the column; the values don't change.
+  void set_encoding(series_encoding new_encoding) {
+    if (new_encoding == encoding()) {
+      return;
+    }
+    settle_code();
+    std::vector<uint64_t> present((extent() + 63) / 64, 0);
+    std::vector<V> vals;
+    vals.reserve(size());
+    for (const auto &[i, v] : std::as_const(*this)) {
+      present[i / 64] |= uint64_t{1} << (i % 64);
+      vals.push_back(v);
+    }
+    if (new_encoding == series_encoding::dictionary) {
+      drop_cells();
+      is_dense = false;
+      enc = std::make_unique<encoded_cells>(mode, resource());
+    } else {
+      enc.reset();
+    }
+    assign_cells(present, std::move(vals));
+  }
+
+  // the dictionary and the codes of an encoded column, or nullptr if the
+  // column isn't encoded. The code of a value is its index in the
+  // dictionary.
+  [[nodiscard]] const key_dictionary<V> *dictionary() const {
+    settle_code();
+    return enc ? &enc->dict : nullptr;
+  }
+  [[nodiscard]] const column_storage<uint32_t> *codes() const {
+    settle_code();
+    return enc ? &enc->codes : nullptr;
+  }
+
+  [[nodiscard]] size_t size() const {
+    if (enc) {
+      return enc->codes.size();
+    }
+    return is_dense ? num_valid : cells.size();
+  }
+  [[nodiscard]] bool empty() const { return size() == 0; }
+
+  [[nodiscard]] bool contains(index i) const {
+    if (enc) {
+      return enc->codes.contains(i);
+    }
+    return is_dense ? is_valid(i) : cells.contains(i);
+  }
+
+  // returns the value at i, default-constructing it if there is none. As
+  // with a vector, references are invalidated by later insertions; in an
+  // encoded column, by reading the column or changing it other than
+  // through operator[].
+  V &operator[](index i) {
+    if (stats) {
+      settle_stats();
+      const auto *old = peek(i);
+      stats->begin_write(i, old ? std::optional<V>(*old) : std::nullopt);
+    }
+    if (enc) {
+      auto [it, added] = enc->pending.try_emplace(i);
+      if (added) {
+        const auto &codes = enc->codes;
+        if (auto c = codes.find(i); c != codes.end()) {
+          it->second = enc->dict.key_at((*c).second);
+        } else {
+          enc->codes[i] = encoded_cells::unsettled;
+        }
+      }
+      return it->second;
+    }
+    if (is_dense && mode == series_layout::automatic && !is_valid(i) &&
+        (num_valid + 1) * sparse_fill_inv <
+            std::max<size_t>(values.size(), i + 1)) {
+      to_sparse();
+    }
+    if (!is_dense) {
+      auto [it, inserted] = cells.try_emplace(i);
+      if (!inserted || mode != series_layout::automatic ||
+          cells.size() * dense_fill_inv < span()) {
+        return it->second;
+      }
+      to_dense();
+      return values[i].value;
+    }
+    if (i >= values.size()) {
+      values.resize(i + 1);
+      valid.resize((i + 64) / 64, 0);
+    }
+    if (!is_valid(i)) {
+      valid[i / 64] |= uint64_t{1} << (i % 64);
+      ++num_valid;
+    }
+    return values[i].value;
+  }
+
+  size_t erase(index i) {
+    if (stats) {
+      settle();
+      const auto &self = *this;
+      if (auto it = self.find(i); it != self.end()) {
+        stats->remove(it->second, i);
+      }
+    }
+    if (enc) {
+      settle_code();
+      return enc->codes.erase(i);
+    }
+    if (!is_dense) {
+      return cells.erase(i);
+    }
+    if (!is_valid(i)) {
+      return 0;
+    }
+    valid[i / 64] &= ~(uint64_t{1} << (i % 64));
+    values[i].value = V{};
+    --num_valid;
+    adapt();
+    return 1;
+  }
+
+  // erases the cells at the selected indices in one pass.
+  void erase(const selection &rows) {
+    if (stats) {
+      settle();
+      for (const auto &[i, v] : std::as_const(*this)) {
+        if (rows.contains(i)) {
+          stats->remove(v, i);
+        }
+      }
+    }
+    if (enc) {
+      settle_code();
+      enc->codes.erase(rows);
+      return;
+    }
+    if (!is_dense) {
+      std::erase_if(cells, [&rows](const auto &el) {
+        return rows.contains(el.first);
+      });
+      return;
+    }
+    const auto &del = rows.words();
+    num_valid = 0;
+    for (size_t w = 0; w < valid.size(); ++w) {
+      if (w < del.size()) {
+        if constexpr (!std::is_trivially_destructible_v<V>) {
+          for (auto word = valid[w] & del[w]; word != 0; word &= word - 1) {
+            values[w * 64 + std::countr_zero(word)].value = V{};
+          }
+        }
+        valid[w] &= ~del[w];
+      }
+      num_valid += std::popcount(valid[w]);
+    }
+    adapt();
+  }
+
+  // moves the cell at each index i to new_index[i], dropping it if that is
+  // INVALID. The new indices must keep the cells in order and never move one
+  // to a larger index.
+  void renumber(const std::vector<index> &new_index) {
+    if (!stats) {
+      move_cells(new_index);
+      return;
+    }
+    settle();
+    size_t before = size();
+    move_cells(new_index);
+    if (size() == before) {
+      stats->renumber(new_index);
+    } else {
+      rescan();
+    }
+  }
+
+  // replaces the contents with vals, which go to the indices whose bits are
+  // set in present, in order. Builds the representation the layout calls
+  // for directly.
+  void assign(const std::vector<uint64_t> &present, std::vector<V> vals) {
+    settle();
+    assign_cells(present, std::move(vals));
+    if (stats) {
+      rescan();
+    }
+  }
+
+  // starts or stops tracking statistics; starting takes one scan.
+  void track_stats(bool on) {
+    if (!on) {
+      stats.reset();
+    } else if (!stats) {
+      stats.emplace();
+      rescan();
+    }
+  }
+  [[nodiscard]] bool tracks_stats() const { return stats.has_value(); }
+
+  // the statistics, or nullptr if the column doesn't track them. The
+  // distinct count is only brought up to date if with_distinct is set.
+  const series_stats<V> *statistics(bool with_distinct = false) const {
+    if (!stats) {
+      return nullptr;
+    }
+    settle();
+    if (stats->stale_extrema() ||
+        (with_distinct && stats->stale_distinct())) {
+      rescan();
+    }
+    return &*stats;
+  }
+
+ private:
+  void move_cells(const std::vector<index> &new_index) {
+    static constexpr index INVALID = std::numeric_limits<index>::max();
+    auto target = [&new_index](index i) {
+      return i < new_index.size() ? new_index[i] : INVALID;
+    };
+    if (enc) {
+      settle_code();
+      enc->codes.renumber(new_index);
+      return;
+    }
+    if (!is_dense) {
+      cell_map moved(resource());
+      for (auto &[i, v] : cells) {
+        if (target(i) != INVALID) {
+          moved.emplace_hint(moved.end(), target(i), std::move(v));
+        }
+      }
+      cells = std::move(moved);
+      return;
+    }
+    std::pmr::vector<uint64_t> moved_valid(valid.size(), 0, resource());
+    size_t new_size = 0;
+    for (index i = next_valid(0); i < values.size(); i = next_valid(i + 1)) {
+      index j = target(i);
+      if (j != INVALID) {
+        if (j != i) {
+          values[j].value = std::move(values[i].value);
+        }
+        moved_valid[j / 64] |= uint64_t{1} << (j % 64);
+        new_size = j + 1;
+      }
+      if (j != i) {
+        values[i].value = V{};
+      }
+    }
+    values.resize(new_size);
+    moved_valid.resize((new_size + 63) / 64);
+    valid = std::move(moved_valid);
+    num_valid = 0;
+    for (auto word : valid) {
+      num_valid += std::popcount(word);
+    }
+    adapt();
+  }
+
+  void assign_cells(const std::vector<uint64_t> &present,
+                    std::vector<V> vals) {
+    if (enc) {
+      enc->pending.clear();
+      std::vector<uint32_t> codes;
+      codes.reserve(vals.size());
+      for (const auto &v : vals) {
+        codes.push_back(encode(v));
+      }
+      enc->codes.assign(present, std::move(codes));
+      return;
+    }
+    size_t count = 0;
+    size_t new_span = 0;
+    for (size_t w = 0; w < present.size(); ++w) {
+      if (present[w] != 0) {
+        count += std::popcount(present[w]);
+        new_span = w * 64 + 64 - std::countl_zero(present[w]);
+      }
+    }
+    if (count != vals.size()) {
+      throw std::invalid_argument("column values don't match their indices");
+    }
+    drop_cells();
+    is_dense = mode == series_layout::dense ||
+               (mode == series_layout::automatic &&
+                count * dense_fill_inv >= new_span && count > 0);
+    size_t next = 0;
+    if (is_dense) {
+      values.resize(new_span);
+      valid.assign(present.begin(),
+                   present.begin() + std::ptrdiff_t((new_span + 63) / 64));
+      num_valid = count;
+      for (size_t w = 0; w < valid.size(); ++w) {
+        for (auto word = valid[w]; word != 0; word &= word - 1) {
+          index i = w * 64 + std::countr_zero(word);
+          values[i].value = std::move(vals[next++]);
+        }
+      }
+      return;
+    }
+    for (size_t w = 0; w < present.size(); ++w) {
+      for (auto word = present[w]; word != 0; word &= word - 1) {
+        cells.emplace_hint(cells.end(), w * 64 + std::countr_zero(word),
+                           std::move(vals[next++]));
+      }
+    }
+  }
+
+ public:
+  // an estimate of the heap memory the column uses, including the heap
+  // buffers of string values.
+  [[nodiscard]] size_t memory_bytes() const {
+    if (enc) {
+      return sizeof(encoded_cells) + enc->codes.memory_bytes() +
+             enc->dict.memory_bytes();
+    }
+    // a std::map node holds the value and a color and three pointers.
+    constexpr size_t node_bytes =
+        sizeof(std::pair<const index, V>) + 4 * sizeof(void *);
+    size_t bytes = is_dense ? values.capacity() * sizeof(cell) +
+                                  valid.capacity() * sizeof(uint64_t)
+                            : cells.size() * node_bytes;
+    if constexpr (std::is_same_v<V, std::string>) {
+      for (const auto &[i, v] : *this) {
+        bytes += heap_bytes(v);
+      }
+    }
+    return bytes;
+  }
+
+  iterator begin() {
+    if (enc) {
+      return iterator(this, {}, next_code(0));
+    }
+    return is_dense ? iterator(this, {}, next_valid(0))
+                    : iterator(this, cells.begin(), 0);
+  }
+  iterator end() {
+    if (enc) {
+      return iterator(this, {}, enc->codes.extent());
+    }
+    return is_dense ? iterator(this, {}, values.size())
+                    : iterator(this, cells.end(), 0);
+  }
+  const_iterator begin() const {
+    if (enc) {
+      return const_iterator(this, {}, next_code(0));
+    }
+    return is_dense ? const_iterator(this, {}, next_valid(0))
+                    : const_iterator(this, cells.begin(), 0);
+  }
+  const_iterator end() const {
+    if (enc) {
+      return const_iterator(this, {}, enc->codes.extent());
+    }
+    return is_dense ? const_iterator(this, {}, values.size())
+                    : const_iterator(this, cells.end(), 0);
+  }
+
+  iterator find(index i) {
+    if (enc || is_dense) {
+      return contains(i) ? iterator(this, {}, i) : end();
+    }
+    return iterator(this, cells.find(i), 0);
+  }
+  const_iterator find(index i) const {
+    if (enc || is_dense) {
+      return contains(i) ? const_iterator(this, {}, i) : end();
+    }
+    return const_iterator(this, cells.find(i), 0);
+  }
+
+  // the first value at an index of at least i.
+  const_iterator lower_bound(index i) const {
+    if (enc) {
+      return const_iterator(this, {}, next_code(i));
+    }
+    if (is_dense) {
+      return const_iterator(this, {}, next_valid(i));
+    }
+    return const_iterator(this, cells.lower_bound(i), 0);
+  }
+
+  // one past the largest index that may hold a value.
+  [[nodiscard]] index extent() const {
+    return enc ? enc->codes.extent() : span();
+  }
+
+  // stored as the layout, the (index, value) pairs and whether statistics
+  // are tracked (they are recomputed on load); a bare array of pairs is read
+  // as an automatic column. An encoded column stores its dictionary, in code
+  // order, and its column of codes instead of the pairs.
+  friend void tag_invoke(boost::json::value_from_tag /*unused*/,
+                         boost::json::value &v,
+                         const column_storage &col) {
+    if (const auto *dict = col.dictionary()) {
+      boost::json::array entries;
+      entries.reserve(dict->capacity());
+      for (const auto &val : dict->keys()) {
+        entries.push_back(boost::json::value_from(val));
+      }
+      v = {{"layout", layout_names[static_cast<size_t>(col.mode)]},
+           {"encoding", "dictionary"},
+           {"dictionary", entries},
+           {"codes", boost::json::value_from(*col.codes())},
+           {"stats", col.tracks_stats()}};
+      return;
+    }
+    boost::json::array pairs;
+    pairs.reserve(col.size());
+    for (const auto &[i, val] : col) {
+      pairs.push_back(boost::json::array{i, boost::json::value_from(val)});
+    }
+    v = {{"layout", layout_names[static_cast<size_t>(col.mode)]},
+         {"cells", pairs},
+         {"stats", col.tracks_stats()}};
+  }
+
+  friend column_storage tag_invoke(
+      boost::json::value_to_tag<column_storage> /*unused*/,
+      const boost::json::value &v) {
+    column_storage col;
+    const auto *obj = v.if_object();
+    auto mode = series_layout::automatic;
+    if (obj != nullptr) {
+      auto name = boost::json::value_to<std::string>(obj->at("layout"));
+      auto it = std::ranges::find(layout_names, name);
+      if (it == layout_names.end()) {
+        throw std::invalid_argument("unknown series layout: " + name);
+      }
+      mode = static_cast<series_layout>(it - layout_names.begin());
+    }
+    const auto *encoding =
+        obj != nullptr ? obj->if_contains("encoding") : nullptr;
+    auto encoding_name = encoding != nullptr
+                             ? boost::json::value_to<std::string>(*encoding)
+                             : "plain";
+    if (encoding_name == "dictionary") {
+      auto entries =
+          boost::json::value_to<std::vector<V>>(obj->at("dictionary"));
+      std::vector<uint64_t> live((entries.size() + 63) / 64, ~uint64_t{0});
+      col.enc = std::make_unique<encoded_cells>(mode, col.resource());
+      col.enc->dict = key_dictionary<V>(std::move(entries), std::move(live));
+      col.enc->codes =
+          boost::json::value_to<column_storage<uint32_t>>(obj->at("codes"));
+      for (const auto &[i, code] : std::as_const(col.enc->codes)) {
+        if (code >= col.enc->dict.capacity()) {
+          throw std::invalid_argument("series code out of range");
+        }
+      }
+    } else if (encoding_name != "plain") {
+      throw std::invalid_argument("unknown series encoding: " +
+                                  encoding_name);
+    } else {
+      col.cells = boost::json::value_to<cell_map>(
+          obj != nullptr ? obj->at("cells") : v);
+    }
+    col.set_layout(mode);
+    if (const auto *st = obj != nullptr ? obj->if_contains("stats") : nullptr) {
+      col.track_stats(st->as_bool());
+    }
+    return col;
+  }
+};
+
+// The cells of a dictionary-encoded column: dict assigns each distinct value
+// a code, and codes holds the code of each cell's value. Values no cell uses
+// any more stay in dict until the column is decoded. A reference handed out
+// for writing is to the cell's own entry in pending, which is encoded into
+// the cell the next time the column is read; until then a new cell's code is
+// unsettled, so a value is only added to dict once it has been written.
+template <typename V>
+struct encoded_column {
+  static constexpr uint32_t unsettled = std::numeric_limits<uint32_t>::max();
+
+  column_storage<uint32_t> codes;
+  key_dictionary<V> dict;
+  std::pmr::map<index, V> pending;
+
+  encoded_column(series_layout mode, std::pmr::memory_resource *mr)
+      : codes(mode, mr), pending(mr) {}
+};
+
+// heap memory in use, split into memory only this object refers to and
+// memory it shares with copies of it.
+struct memory_usage {
+  size_t unique_bytes = 0;
+  size_t shared_bytes = 0;
+};
+
+// the memory a series uses, and how it is currently stored.
+struct series_memory_usage {
+  bool dense = false;
+  series_encoding encoding = series_encoding::plain;
+  memory_usage values;
+  size_t index_bytes = 0;  // its secondary index, if it has one
+
+  [[nodiscard]] size_t total_bytes() const {
+    return values.unique_bytes + values.shared_bytes + index_bytes;
+  }
+
+  friend void tag_invoke(boost::json::value_from_tag /*unused*/,
+                         boost::json::value &v,
+                         const series_memory_usage &u) {
+    v = {{"storage", u.dense ? "dense" : "sparse"},
+         {"encoding",
+          u.encoding == series_encoding::dictionary ? "dictionary" : "plain"},
+         {"unique_bytes", u.values.unique_bytes},
+         {"shared_bytes", u.values.shared_bytes},
+         {"index_bytes", u.index_bytes},
+         {"total_bytes", u.total_bytes()}};
+  }
+};
+
+// the memory an mvmap uses: its key dictionary and each of its series.
+// Storage a series shares with a copy of it is counted by both.
+struct table_memory_usage {
+  size_t key_bytes = 0;
+  std::map<std::string, series_memory_usage> series;
+
+  [[nodiscard]] size_t total_bytes() const {
+    size_t bytes = key_bytes;
+    for (const auto &[sel, u] : series) {
+      bytes += u.total_bytes();
+    }
+    return bytes;
+  }
+
+  friend void tag_invoke(boost::json::value_from_tag /*unused*/,
+                         boost::json::value &v,
+                         const table_memory_usage &u) {
+    v = {{"key_bytes", u.key_bytes},
+         {"series", boost::json::value_from(u.series)},
+         {"total_bytes", u.total_bytes()}};
+  }
+};
+
+// A column is a copy-on-write handle to a column_storage: copies share the
+// storage, and whichever side is written to next gets its own copy first.
+// Copying a series is therefore O(1), and a snapshot only costs memory once
+// it diverges from the original.
+template <typename V>
+class column {
+  using storage = column_storage<V>;
+
+  std::shared_ptr<storage> st = std::make_shared<storage>();
+
+  [[nodiscard]] const storage &get() const { return *st; }
+
+  // returns the storage for writing, detaching it from any copies.
+  storage &mut() {
+    if (st.use_count() > 1) {
+      st = std::allocate_shared<storage>(
+          std::pmr::polymorphic_allocator<storage>(st->resource()), *st);
+    }
+    return *st;
+  }
+
+ public:
+  using key_type = index;
+  using mapped_type = V;
+  // iteration only reads, so it never detaches the storage; write cells
+  // through operator[].
+  using iterator = typename storage::const_iterator;
+  using const_iterator = typename storage::const_iterator;
+
+  column() = default;
+  // the storage, and the shared_ptr's control block, are allocated from mr.
+  explicit column(
+      series_layout mode,
+      std::pmr::memory_resource *mr = std::pmr::get_default_resource())
+      : st(std::allocate_shared<storage>(
+            std::pmr::polymorphic_allocator<storage>(mr), mode, mr)) {}
+
+  // true if the storage is shared with a copy of this column.
+  [[nodiscard]] bool shared() const { return st.use_count() > 1; }
+
+  [[nodiscard]] memory_usage memory() const {
+    auto bytes = get().memory_bytes();
+    return shared() ? memory_usage{0, bytes} : memory_usage{bytes, 0};
+  }
+
+  [[nodiscard]] series_layout layout() const { return get().layout(); }
+  [[nodiscard]] bool dense() const { return get().dense(); }
+  void set_layout(series_layout mode) {
+    if (mode != layout()) {
+      mut().set_layout(mode);
+    }
+  }
+
+  [[nodiscard]] series_encoding encoding() const { return get().encoding(); }
+  void set_encoding(series_encoding encoding) {
+    if (encoding != this->encoding()) {
+      mut().set_encoding(encoding);
+    }
+  }
+  [[nodiscard]] const key_dictionary<V> *dictionary() const {
+    return get().dictionary();
+  }
+  [[nodiscard]] const column_storage<uint32_t> *codes() const {
+    return get().codes();
+  }
+
+  [[nodiscard]] size_t size() const { return get().size(); }
+  [[nodiscard]] bool empty() const { return get().empty(); }
+  [[nodiscard]] bool contains(index i) const { return get().contains(i); }
+
+  V &operator[](index i) { return mut()[i]; }
+  size_t erase(index i) { return contains(i) ? mut().erase(i) : 0; }
+  void erase(const selection &rows) { mut().erase(rows); }
+  void renumber(const std::vector<index> &new_index) {
+    mut().renumber(new_index);
+  }
+  void assign(const std::vector<uint64_t> &present, std::vector<V> vals) {
+    mut().assign(present, std::move(vals));
+  }
+
+  void track_stats(bool on) {
+    if (on != tracks_stats()) {
+      mut().track_stats(on);
+    }
+  }
+  [[nodiscard]] bool tracks_stats() const { return get().tracks_stats(); }
+  const series_stats<V> *statistics(bool with_distinct = false) const {
+    return get().statistics(with_distinct);
+  }
+
+  const_iterator begin() const { return get().begin(); }
+  const_iterator end() const { return get().end(); }
+  const_iterator find(index i) const { return get().find(i); }
+  const_iterator lower_bound(index i) const { return get().lower_bound(i); }
+  [[nodiscard]] index extent() const { return get().extent(); }
+
+  friend void tag_invoke(boost::json::value_from_tag /*unused*/,
+                         boost::json::value &v, const column &col) {
+    v = boost::json::value_from(col.get());
+  }
+
+  friend column tag_invoke(boost::json::value_to_tag<column> /*unused*/,
+                           const boost::json::value &v) {
+    column col;
+    col.st = std::make_shared<storage>(boost::json::value_to<storage>(v));
+    return col;
+  }
+};
+
+template <typename V>
+using value_count_map = std::unordered_map<V, size_t, key_hash<V>>;
+
+// columns with fewer values than this per thread are counted on fewer
+// threads.
+inline constexpr size_t min_values_per_thread = size_t{1} << 16;
+
+// counts the occurrences of each value of a column. The index range is split
+// into one block per thread (num_threads, or one per core if 0), each thread
+// counts its block into a table of its own, and the tables are merged at the
+// end.
+template <typename V>
+value_count_map<V> value_counts(const column<V> &col,
+                                unsigned num_threads = 0) {
+  // an encoded column is counted by code, which needs no hashing.
+  if (const auto *dict = col.dictionary()) {
+    std::vector<size_t> per_code(dict->capacity(), 0);
+    for (const auto &[i, code] : *col.codes()) {
+      ++per_code[code];
+    }
+    value_count_map<V> counts;
+    for (index code = 0; code < per_code.size(); ++code) {
+      if (per_code[code] > 0) {
+        counts.emplace(dict->key_at(code), per_code[code]);
+      }
+    }
+    return counts;
+  }
+  if (num_threads == 0) {
+    num_threads = std::max(1U, std::thread::hardware_concurrency());
+  }
+  num_threads = unsigned(std::clamp<size_t>(
+      col.size() / min_values_per_thread, 1, num_threads));
+  index end = col.extent();
+  index block = (end + num_threads - 1) / num_threads;
+  std::vector<value_count_map<V>> counts(num_threads);
+  auto count_block = [&col, &counts, end, block](unsigned t) {
+    index lo = std::min(end, t * block);
+    auto last = col.lower_bound(std::min(end, lo + block));
+    auto &ct = counts[t];
+    for (auto it = col.lower_bound(lo); it != last; ++it) {
+      ++ct[(*it).second];
+    }
+  };
+  {
+    std::vector<std::jthread> workers;
+    for (unsigned t = 1; t < num_threads; ++t) {
+      workers.emplace_back(count_block, t);
+    }
+    count_block(0);
+  }
+  auto &total = counts.front();
+  for (auto &part : counts | std::views::drop(1)) {
+    while (!part.empty()) {
+      auto [pos, inserted, node] = total.insert(part.extract(part.begin()));
+      if (!inserted) {
+        pos->second += node.mapped();
+      }
+    }
+  }
+  return std::move(total);
+}
+
+// the k most frequent values and their counts, most frequent first; ties go
+// to the smaller value.
+template <typename V>
+std::vector<std::pair<V, size_t>> top_counts(const value_count_map<V> &counts,
+                                             size_t k) {
+  std::vector<std::pair<V, size_t>> top(std::min(k, counts.size()));
+  std::partial_sort_copy(counts.begin(), counts.end(), top.begin(), top.end(),
+                         [](const auto &a, const auto &b) {
+                           return a.second != b.second ? a.second > b.second
+                                                       : a.first < b.first;
+                         });
+  return top;
+}
+
+// A key_dictionary assigns each key of an mvmap an index. Indices are
+// allocated sequentially and never reused, so index -> key is a vector (with
+// a bitmap of live indices), and key -> index is an open-addressing hash
+// table with linear probing over (hash, index) slots that compares keys
+// through that vector. All three allocate from a memory resource; the keys'
+// own heap buffers, such as those of long strings, don't.
+template <typename K>
+class key_dictionary {
+  static constexpr index EMPTY = std::numeric_limits<index>::max();
+  static constexpr size_t min_slots = 16;
+
+  struct slot {
+    uint64_t hash = 0;
+    index idx = EMPTY;
+  };
+
+  // a vector<bool> can't hand out references to its elements, so bool keys
+  // are stored wrapped.
+  struct bool_key {
+    bool key = false;
+    bool_key() = default;
+    bool_key(bool k) : key(k) {}
+    operator const bool &() const { return key; }
+  };
+  using stored_key = std::conditional_t<std::is_same_v<K, bool>, bool_key, K>;
+
+  std::pmr::vector<slot> slots;
+  std::pmr::vector<stored_key> by_index;
+  std::pmr::vector<uint64_t> live;
+  size_t num_keys = 0;
+
+  // spreads std::hash's output, which is the identity for integers, over
+  // the low bits used to pick a slot. A std::string_view hashes as the
+  // std::string with its characters.
+  template <typename L>
+  static uint64_t hash_of(const L &k) {
+    return mix_bits(key_hash<L>{}(k));
+  }
+
+  [[nodiscard]] size_t mask() const { return slots.size() - 1; }
+
+  // returns the slot holding k, or the empty slot where it would go. k is a
+  // key, or a std::string_view for a string key.
+  template <typename L>
+  [[nodiscard]] size_t probe(const L &k, uint64_t h) const {
+    size_t pos = h & mask();
+    while (slots[pos].idx != EMPTY &&
+           (slots[pos].hash != h || by_index[slots[pos].idx] != k)) {
+      pos = (pos + 1) & mask();
+    }
+    return pos;
+  }
+
+  // the index of k, a key or a std::string_view for a string key.
+  template <typename L>
+  [[nodiscard]] std::optional<index> find_like(const L &k) const {
+    if (num_keys == 0) {
+      return std::nullopt;
+    }
+    auto pos = probe(k, hash_of(k));
+    if (slots[pos].idx == EMPTY) {
+      return std::nullopt;
+    }
+    return slots[pos].idx;
+  }
+
+  void rehash(size_t num_slots) {
+    std::pmr::vector<slot> old(num_slots, slots.get_allocator());
+    std::swap(slots, old);
+    for (const auto &s : old) {
+      if (s.idx != EMPTY) {
+        size_t pos = s.hash & mask();
+        while (slots[pos].idx != EMPTY) {
+          pos = (pos + 1) & mask();
+        }
+        slots[pos] = s;
+      }
+    }
+  }
+
+  // keeps the load factor at or below 3/4.
+  void grow_for(size_t n) {
+    if (n * 4 > slots.size() * 3) {
+      rehash(std::bit_ceil(std::max(min_slots, n * 4 / 3 + 1)));
+    }
+  }
+
+  void link(index i, uint64_t h, size_t pos) {
+    slots[pos] = {h, i};
+    live[i / 64] |= uint64_t{1} << (i % 64);
+    ++num_keys;
+  }
+
+ public:
+  key_dictionary() = default;
+  explicit key_dictionary(std::pmr::memory_resource *mr)
+      : slots(mr), by_index(mr), live(mr) {}
+
+  // rebuilds a dictionary from its (index, key) pairs.
+  explicit key_dictionary(const std::map<index, K> &pairs) {
+    size_t cap = pairs.empty() ? 0 : pairs.rbegin()->first + 1;
+    by_index.resize(cap);
+    live.resize((cap + 63) / 64, 0);
+    grow_for(pairs.size());
+    for (const auto &[i, k] : pairs) {
+      auto h = hash_of(k);
+      auto pos = probe(k, h);
+      if (slots[pos].idx != EMPTY) {
+        throw std::invalid_argument("duplicate key in key dictionary");
+      }
+      by_index[i] = k;
+      link(i, h, pos);
+    }
+  }
+
+  // rebuilds a dictionary from its keys by index and the bitmap of live
+  // indices; the keys at dead indices are ignored.
+  key_dictionary(std::vector<K> keys, const std::vector<uint64_t> &live_bits)
+      : live(live_bits.begin(), live_bits.end()) {
+    by_index.assign(std::make_move_iterator(keys.begin()),
+                    std::make_move_iterator(keys.end()));
+    live.resize((by_index.size() + 63) / 64, 0);
+    if (by_index.size() % 64 != 0) {
+      live.back() &= (uint64_t{1} << (by_index.size() % 64)) - 1;
+    }
+    size_t n = 0;
+    for (auto word : live) {
+      n += std::popcount(word);
+    }
+    grow_for(n);
+    for (size_t w = 0; w < live.size(); ++w) {
+      for (auto word = live[w]; word != 0; word &= word - 1) {
+        index i = w * 64 + std::countr_zero(word);
+        auto h = hash_of(by_index[i]);
+        auto pos = probe(by_index[i], h);
+        if (slots[pos].idx != EMPTY) {
+          throw std::invalid_argument("duplicate key in key dictionary");
+        }
+        slots[pos] = {h, i};
+        ++num_keys;
+      }
+    }
+  }
+
+  [[nodiscard]] size_t size() const { return num_keys; }
+
+  // an estimate of the heap memory the dictionary uses, including the heap
+  // buffers of string keys.
+  [[nodiscard]] size_t memory_bytes() const {
+    size_t bytes = slots.capacity() * sizeof(slot) +
+                   by_index.capacity() * sizeof(stored_key) +
+                   live.capacity() * sizeof(uint64_t);
+    for (const auto &k : by_index) {
+      bytes += heap_bytes(k);
+    }
+    return bytes;
+  }
+
+  // the bitmap of live indices, 64 to a word.
+  [[nodiscard]] const std::pmr::vector<uint64_t> &live_bits() const {
+    return live;
+  }
+
+  // one past the largest index ever allocated.
+  [[nodiscard]] size_t capacity() const { return by_index.size(); }
+
+  void reserve(size_t n) {
+    by_index.reserve(n);
+    live.reserve((n + 63) / 64);
+    grow_for(n);
+  }
+
+  [[nodiscard]] std::optional<index> find(const K &k) const {
+    return find_like(k);
+  }
+
+  // finds a string key by its characters, without building a string.
+  template <std::same_as<std::string_view> L>
+    requires std::same_as<K, std::string>
+  [[nodiscard]] std::optional<index> find(L k) const {
+    return find_like(k);
+  }
+
+  [[nodiscard]] bool contains(const K &k) const { return find(k).has_value(); }
+
+  [[nodiscard]] bool has_index(index i) const {
+    return i < by_index.size() && ((live[i / 64] >> (i % 64)) & 1) != 0;
+  }
+
+  // assumes has_index(i).
+  [[nodiscard]] const K &key_at(index i) const { return by_index[i]; }
+
+  // returns the index of k, allocating the next one if k is new, and whether
+  // it was inserted.
+  std::pair<index, bool> insert(const K &k) {
+    grow_for(num_keys + 1);
+    auto h = hash_of(k);
+    auto pos = probe(k, h);
+    if (slots[pos].idx != EMPTY) {
+      return {slots[pos].idx, false};
+    }
+    index i = by_index.size();
+    by_index.push_back(k);
+    if (i % 64 == 0) {
+      live.push_back(0);
+    }
+    link(i, h, pos);
+    return {i, true};
+  }
+
+  // inserts key(0), ..., key(n - 1) and writes the index of key(j) to
+  // out[j]; returns how many were new. key may return std::string_views for
+  // a string key, in which case only the new keys are copied into strings.
+  // A batch of keys is hashed and their slots prefetched before any is
+  // probed, so the cache misses of a large table overlap rather than follow
+  // one another.
+  template <typename F>
+  size_t insert_batch(size_t n, F key, std::span<index> out) {
+    using key_type = std::remove_cvref_t<decltype(key(size_t{}))>;
+    static_assert(std::same_as<key_type, K> ||
+                  (std::same_as<K, std::string> &&
+                   std::same_as<key_type, std::string_view>));
+    constexpr size_t batch = 16;
+    uint64_t hashes[batch];
+    size_t added = 0;
+    for (size_t lo = 0; lo < n; lo += batch) {
+      size_t hi = std::min(n, lo + batch);
+      grow_for(num_keys + (hi - lo));
+      for (auto j = lo; j < hi; ++j) {
+        hashes[j - lo] = hash_of(key(j));
+        __builtin_prefetch(&slots[hashes[j - lo] & mask()]);
+      }
+      for (auto j = lo; j < hi; ++j) {
+        const auto &k = key(j);
+        auto h = hashes[j - lo];
+        auto pos = probe(k, h);
+        if (slots[pos].idx != EMPTY) {
+          out[j] = slots[pos].idx;
+          continue;
+        }
+        index i = by_index.size();
+        by_index.emplace_back(k);
+        if (i % 64 == 0) {
+          live.push_back(0);
+        }
+        link(i, h, pos);
+        out[j] = i;
+        ++added;
+      }
+    }
+    return added;
+  }
+
+  // removes the key at index i, if any. Uses backward-shift deletion, so
+  // the table never fills up with tombstones.
+  void erase(index i) {
+    if (!has_index(i)) {
+      return;
+    }
+    auto hole = probe(by_index[i], hash_of(by_index[i]));
+    for (size_t next = (hole + 1) & mask(); slots[next].idx != EMPTY;
+         next = (next + 1) & mask()) {
+      size_t home = slots[next].hash & mask();
+      // an entry may move back into the hole only if that doesn't put it
+      // before its home slot.
+      if (((next - home) & mask()) >= ((next - hole) & mask())) {
+        slots[hole] = slots[next];
+        hole = next;
+      }
+    }
+    slots[hole].idx = EMPTY;
+    live[i / 64] &= ~(uint64_t{1} << (i % 64));
+    by_index[i] = K{};
+    --num_keys;
+  }
+
+  // removes the keys at the selected indices, then rebuilds the hash table
+  // in place in a single pass over the slots.
+  void erase(const selection &rows) {
+    const auto &del = rows.words();
+    for (size_t w = 0; w < std::min(del.size(), live.size()); ++w) {
+      for (auto word = live[w] & del[w]; word != 0; word &= word - 1) {
+        by_index[w * 64 + std::countr_zero(word)] = K{};
+        --num_keys;
+      }
+      live[w] &= ~del[w];
+    }
+    if (slots.empty()) {
+      return;
+    }
+    // start after a slot that is already empty, so no probe sequence wraps
+    // around past the start. Each remaining key is then reinserted into the
+    // part of the table already processed, which ends at its current slot.
+    size_t start = 0;
+    while (slots[start].idx != EMPTY) {
+      ++start;
+    }
+    for (size_t n = 1; n <= slots.size(); ++n) {
+      size_t pos = (start + n) & mask();
+      auto s = slots[pos];
+      if (s.idx == EMPTY) {
+        continue;
+      }
+      slots[pos].idx = EMPTY;
+      if (has_index(s.idx)) {
+        size_t dst = s.hash & mask();
+        while (slots[dst].idx != EMPTY) {
+          dst = (dst + 1) & mask();
+        }
+        slots[dst] = s;
+      }
+    }
+  }
+
+  // renumbers the live keys densely, in index order, and returns the new
+  // index of each old one (EMPTY for the dead ones).
+  std::vector<index> compact() {
+    std::vector<index> new_index(by_index.size(), EMPTY);
+    index next = 0;
+    for_all([&new_index, &next](const K & /*unused*/, index i) {
+      new_index[i] = next++;
+    });
+    for (index i = 0; i < by_index.size(); ++i) {
+      if (new_index[i] != EMPTY && new_index[i] != i) {
+        by_index[new_index[i]] = std::move(by_index[i]);
+      }
+    }
+    by_index.resize(next);
+    live.assign((next + 63) / 64, 0);
+    for (index i = 0; i < next; ++i) {
+      live[i / 64] |= uint64_t{1} << (i % 64);
+    }
+    for (auto &s : slots) {
+      if (s.idx != EMPTY) {
+        s.idx = new_index[s.idx];
+      }
+    }
+    return new_index;
+  }
+
+  // F takes (K key, index), in index order. F must not add keys.
+  template <typename F>
+  void for_all(F f) const {
+    for (size_t w = 0; w < live.size(); ++w) {
+      for (auto word = live[w]; word != 0; word &= word - 1) {
+        index i = w * 64 + std::countr_zero(word);
+        f(by_index[i], i);
+      }
+    }
+  }
+
+  // iterates over the live keys, in index order.
+  class key_iterator {
+    const key_dictionary *dict = nullptr;
+    index pos = 0;
+
+    void skip_dead() {
+      while (pos < dict->capacity() && !dict->has_index(pos)) {
+        ++pos;
+      }
+    }
+
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = K;
+    using pointer = const K *;
+    using reference = const K &;
+
+    key_iterator() = default;
+    key_iterator(const key_dictionary *dict, index pos) : dict(dict), pos(pos) {
+      skip_dead();
+    }
+
+    reference operator*() const { return dict->by_index[pos]; }
+    pointer operator->() const { return &**this; }
+    key_iterator &operator++() {
+      ++pos;
+      skip_dead();
+      return *this;
+    }
+    key_iterator operator++(int) {
+      auto old = *this;
+      ++*this;
+      return old;
+    }
+    bool operator==(const key_iterator &other) const {
+      return pos == other.pos;
+    }
+  };
+
+  // the live keys, in index order.
+  [[nodiscard]] std::ranges::subrange<key_iterator> keys() const {
+    return {key_iterator(this, 0), key_iterator(this, capacity())};
+  }
+
+  // stored as the (index, key) pairs, like the std::map it replaces.
+  friend void tag_invoke(boost::json::value_from_tag /*unused*/,
+                         boost::json::value &v, const key_dictionary &d) {
+    boost::json::array pairs;
+    pairs.reserve(d.size());
+    d.for_all([&pairs](const K &k, index i) {
+      pairs.push_back(boost::json::array{i, boost::json::value_from(k)});
+    });
+    v = pairs;
+  }
+
+  friend key_dictionary tag_invoke(
+      boost::json::value_to_tag<key_dictionary> /*unused*/,
+      const boost::json::value &v) {
+    return key_dictionary(boost::json::value_to<std::map<index, K>>(v));
+  }
+};
+
+namespace binary {
+// Assigns each distinct string written to a binary file an id, in order of
+// first appearance. The strings must outlive the table.
+class string_table {
+  key_dictionary<std::string_view> dict;
+
+ public:
+  void add(std::string_view s) {
+    if (dict.insert(s).first > std::numeric_limits<uint32_t>::max()) {
+      throw std::length_error("too many strings for the binary format");
+    }
+  }
+
+  // adds the strings within a value, if any.
+  template <typename T>
+  void add_value(const T &v) {
+    if constexpr (is_pair<T>::value) {
+      add_value(v.first);
+      add_value(v.second);
+    } else if constexpr (std::is_same_v<T, std::string>) {
+      add(v);
+    }
+  }
+
+  // assumes s was added.
+  [[nodiscard]] uint32_t id(std::string_view s) const {
+    return uint32_t(*dict.find(s));
+  }
+
+  // the strings, in id order.
+  [[nodiscard]] auto all() const { return dict.keys(); }
+};
+}  // namespace binary
+
+// comparison operators that can be answered by a sorted index.
+enum class cmp_op { lt, le, gt, ge, eq };
+
+// A sorted_index is a secondary index over a series: the series' values in
+// ascending order, along with the index each value came from.
+template <typename V>
+class sorted_index {
+  std::vector<V> keys;
+  std::vector<index> order;
+
+  template <typename B>
+  static constexpr bool comparable_v =
+      (std::is_arithmetic_v<V> && !std::is_same_v<V, bool> &&
+       std::is_arithmetic_v<B> && !std::is_same_v<B, bool>) ||
+      (std::is_same_v<V, std::string> && std::is_same_v<B, std::string>);
+
+ public:
+  sorted_index() = default;
+
+  // sorts the (value, index) pairs of a series.
+  explicit sorted_index(const column<V> &ser) {
+    std::vector<std::pair<V, index>> sorted;
+    sorted.reserve(ser.size());
+    for (const auto &[i, v] : ser) {
+      sorted.emplace_back(v, i);
+    }
+    std::sort(sorted.begin(), sorted.end());
+    keys.reserve(sorted.size());
+    order.reserve(sorted.size());
+    for (auto &[v, i] : sorted) {
+      keys.push_back(std::move(v));
+      order.push_back(i);
+    }
+  }
+
+  // rebuilds an index from a previously saved order, or returns nullopt if
+  // the order no longer matches the series.
+  static std::optional<sorted_index> from_order(const column<V> &ser,
+                                                std::vector<index> order) {
+    if (order.size() != ser.size()) {
+      return std::nullopt;
+    }
+    sorted_index si;
+    si.keys.reserve(order.size());
+    for (auto i : order) {
+      auto it = ser.find(i);
+      if (it == ser.end() ||
+          (!si.keys.empty() && it->second < si.keys.back())) {
+        return std::nullopt;
+      }
+      si.keys.push_back(it->second);
+    }
+    si.order = std::move(order);
+    return si;
+  }
+
+  [[nodiscard]] size_t size() const { return order.size(); }
+  [[nodiscard]] const std::vector<index> &sorted_order() const { return order; }
+
+  // an estimate of the heap memory the index uses.
+  [[nodiscard]] size_t memory_bytes() const {
+    size_t bytes = order.capacity() * sizeof(index);
+    if constexpr (std::is_same_v<V, bool>) {
+      bytes += keys.capacity() / 8;
+    } else {
+      bytes += keys.capacity() * sizeof(V);
+      for (const auto &k : keys) {
+        bytes += heap_bytes(k);
+      }
+    }
+    return bytes;
+  }
+
+  // returns the [first, last) positions in sorted order of the values v for
+  // which (v op bound) holds, or nullopt if V and B can't be compared.
+  template <typename B>
+  std::optional<std::pair<size_t, size_t>> range(cmp_op op,
+                                                 const B &bound) const {
+    if constexpr (!comparable_v<B>) {
+      return std::nullopt;
+    } else {
+      auto lower = [&]() {
+        return static_cast<size_t>(
+            std::lower_bound(keys.begin(), keys.end(), bound,
+                             [](const V &v, const B &b) { return v < b; }) -
+            keys.begin());
+      };
+      auto upper = [&]() {
+        return static_cast<size_t>(
+            std::upper_bound(keys.begin(), keys.end(), bound,
+                             [](const B &b, const V &v) { return b < v; }) -
+            keys.begin());
+      };
+      switch (op) {
+        case cmp_op::lt:
+          return std::make_pair(size_t{0}, lower());
+        case cmp_op::le:
+          return std::make_pair(size_t{0}, upper());
+        case cmp_op::gt:
+          return std::make_pair(upper(), keys.size());
+        case cmp_op::ge:
+          return std::make_pair(lower(), keys.size());
+        case cmp_op::eq:
+          return std::make_pair(lower(), upper());
+      }
+      return std::nullopt;
+    }
+  }
+};
 template <typename K, typename... Vs>
 class mvmap {
   template <typename T>
-  using series = std::map<index, T>;
-  using key_to_idx = std::map<K, index>;
-  using idx_to_key = std::map<index, K>;
+  using series = column<T>;
   using variants = std::variant<Vs...>;
 
   template <typename V>
@@ -79,10 +1967,99 @@ class mvmap {
 
   // A locator is an opaque handle to a key in a series.
 
-  idx_to_key itk;
-  key_to_idx kti;
+  // no version is ever equal to this one.
+  static constexpr uint64_t NO_VERSION = std::numeric_limits<uint64_t>::max();
+
+  // A secondary index over a series, valid while the series is still at the
+  // version the index was built from. A stale index is rebuilt the next time
+  // it is probed.
+  struct index_entry {
+    std::variant<sorted_index<Vs>...> idx;
+    uint64_t version = NO_VERSION;
+  };
+
+  // A cached_selection is the result of evaluating a where rule, together
+  // with the versions of the key set and of the series it read. The hash
+  // finds an entry quickly; the rule itself decides whether it matches.
+  struct cached_selection {
+    uint64_t rule_hash;
+    std::string rule;
+    uint64_t key_version;
+    std::map<std::string, uint64_t> deps;
+    selection sel;
+  };
+  static constexpr size_t selection_cache_size = 8;
+  // selections with larger bitmaps aren't saved with the map; they are cheaper
+  // to recompute than to carry through every save and load.
+  static constexpr size_t saved_selection_bytes = 16 * 1024;
+
+  key_dictionary<K> dict;
   std::map<std::string, std::variant<series<Vs>...>> data;
   std::map<std::string, std::string> series_desc;
+  std::map<std::string, index_entry> indexes;
+
+  // where the series allocate their memory.
+  std::pmr::memory_resource *resource = std::pmr::get_default_resource();
+
+  // Modification tracking: every change to a series (or to the set of keys)
+  // stamps it with the next tick of a logical clock, so versions are never
+  // reused, even by a series that is dropped and added again.
+  uint64_t clock = 0;
+  uint64_t key_version = 0;
+  std::map<std::string, uint64_t> versions;
+  std::vector<cached_selection> selection_cache;  // most recently used last
+
+  uint64_t tick() { return ++clock; }
+
+  void touch_all_series() {
+    key_version = tick();
+    for (auto &el : versions) {
+      el.second = key_version;
+    }
+  }
+
+  // returns the index on a series, rebuilding it first if it is stale.
+  index_entry *fresh_index(const std::string &sel) {
+    auto it = indexes.find(sel);
+    if (it == indexes.end() || !has_series(sel)) {
+      return nullptr;
+    }
+    if (it->second.version != versions[sel]) {
+      std::visit(
+          [&it](auto &coldata) {
+            using T = std::decay_t<decltype(coldata)>::mapped_type;
+            it->second.idx = sorted_index<T>(coldata);
+          },
+          data[sel]);
+      it->second.version = versions[sel];
+    }
+    return &it->second;
+  }
+
+  [[nodiscard]] const std::string &description(const std::string &sel) const {
+    static const std::string none;
+    auto it = series_desc.find(sel);
+    return it == series_desc.end() ? none : it->second;
+  }
+
+  // reads the values of a series stored with type code if V has that code,
+  // and returns whether it did.
+  template <typename V>
+  bool read_binary_series(binary::reader &r,
+                          const std::vector<std::string_view> &strings,
+                          binary::type_code code, const std::string &sel,
+                          series_layout layout, series_encoding encoding,
+                          size_t count, const std::vector<uint64_t> &present) {
+    if (code != binary::code_of<V>()) {
+      return false;
+    }
+    series<V> col(layout, resource);
+    col.set_encoding(encoding);
+    col.assign(present, r.values<V>(strings, count));
+    data[sel] = std::move(col);
+    versions[sel] = tick();
+    return true;
+  }
 
  public:
   // A series_proxy is a reference to a series in an mvmap.
@@ -90,39 +2067,47 @@ class mvmap {
   class series_proxy {
     std::string m_id;
     std::string m_desc;
-    key_to_idx &kti_r;
-    idx_to_key &itk_r;
+    key_dictionary<K> &dict_r;
     series<V> &series_r;
+    mvmap<K, Vs...> &map_r;
+    uint64_t &version_r;
 
     using series_type = V;
 
+    // called on every write so that indexes and cached selections that read
+    // this series are recomputed.
+    void touch() { version_r = map_r.tick(); }
+
     // returns true if there is an index assigned to a given key
-    bool has_idx_at_key(K k) const { return kti_r.contains(k); }
+    bool has_idx_at_key(K k) const { return dict_r.contains(k); }
     // returns true if there is a key assigned to a given locator
-    bool has_key_at_index(locator l) const { return itk_r.contains(l.loc); }
+    bool has_key_at_index(locator l) const { return dict_r.has_index(l.loc); }
 
     // returns or creates the index for a key.
     index get_idx(K k) {
-      if (!has_idx_at_key(k)) {
-        index i{kti_r.size()};
-        kti_r[k] = i;
-        itk_r[i] = k;
-        return i;
+      auto [i, inserted] = dict_r.insert(k);
+      if (inserted) {
+        map_r.key_version = map_r.tick();
       }
-      return kti_r[k];
+      return i;
     }
 
    public:
     series_proxy(std::string id, series<V> &ser, mvmap<K, Vs...> &m)
-        : m_id(std::move(id)), kti_r(m.kti), itk_r(m.itk), series_r(ser) {}
+        : m_id(std::move(id)),
+          dict_r(m.dict),
+          series_r(ser),
+          map_r(m),
+          version_r(m.versions[m_id]) {}
 
     series_proxy(std::string id, const std::string &desc, series<V> &ser,
                  mvmap<K, Vs...> &m)
         : m_id(std::move(id)),
           m_desc(desc),
-          kti_r(m.kti),
-          itk_r(m.itk),
-          series_r(ser) {}
+          dict_r(m.dict),
+          series_r(ser),
+          map_r(m),
+          version_r(m.versions[m_id]) {}
 
     bool is_string_v() const { return std::is_same_v<V, std::string>; }
     bool is_double_v() const { return std::is_same_v<V, double>; }
@@ -131,87 +2116,111 @@ class mvmap {
 
     std::string id() const { return m_id; }
     std::string desc() const { return m_desc; }
-    V &operator[](K k) { return series_r[get_idx(k)]; }
+    [[nodiscard]] size_t size() const { return series_r.size(); }
+    V &operator[](K k) {
+      touch();
+      return series_r[get_idx(k)];
+    }
     const V &operator[](K k) const { return series_r[get_idx(k)]; }
 
     // this assumes the key exists.
-    V &operator[](locator l) { return series_r[l.loc]; }
-    const V &operator[](locator l) const { return series_r[l.loc]; }
-
-    std::optional<std::reference_wrapper<V>> at(locator l) {
-      if (!has_key_at_index(l) || !series_r.contains(l.loc)) {
-        return std::nullopt;
-      }
+    V &operator[](locator l) {
+      touch();
       return series_r[l.loc];
-    };
-    std::optional<std::reference_wrapper<const V>> at(locator l) const {
-      if (!has_key_at_index(l) || !series_r.contains(l.loc)) {
-        return std::nullopt;
+    }
+    const V &operator[](locator l) const {
+      if (const auto *v = find(l)) {
+        return *v;
       }
       return series_r[l.loc];
-    };
+    }
 
-    std::optional<std::reference_wrapper<V>> at(K k) {
-      if (!has_idx_at_key(k) || !series_r.contains(get_idx(k))) {
+    // at() only reads, so it neither changes the series' version nor
+    // detaches its storage from copies; write through operator[].
+    std::optional<std::reference_wrapper<const V>> at(locator l) const {
+      const auto *v = find(l);
+      if (!has_key_at_index(l) || v == nullptr) {
         return std::nullopt;
       }
-      return series_r[get_idx(k)];
+      return *v;
     };
 
     std::optional<std::reference_wrapper<const V>> at(K k) const {
-      if (!has_idx_at_key(k) || !series_r.contains(get_idx(k))) {
+      auto i = dict_r.find(k);
+      const auto *v = i ? find(locator(*i)) : nullptr;
+      if (v == nullptr) {
         return std::nullopt;
       }
-      return series_r[get_idx(k)];
+      return *v;
     };
 
+    // returns a pointer to the value at a locator, or nullptr if the series
+    // has no value there. Unlike at(), this does a single lookup and assumes
+    // the locator came from this mvmap.
+    const V *find(locator l) const {
+      const auto &ser = std::as_const(series_r);
+      auto it = ser.find(l.loc);
+      return it == ser.end() ? nullptr : &it->second;
+    }
+
     // this will create the key/index if it doesn't exist.
     locator get_loc(K k) { return locator(get_idx(k)); }
 
     // F takes (K key, locator, V value)
     template <typename F>
     void for_all(F f) {
-      for (auto el : series_r) {
-        f(itk_r[el.first], locator(el.first), el.second);
+      for (const auto &[i, v] : std::as_const(series_r)) {
+        f(dict_r.key_at(i), locator(i), std::as_const(v));
       }
     };
 
     template <typename F>
     void for_all(F f) const {
-      for (auto el : series_r) {
-        f(itk_r[el.first], locator(el.first), el.second);
+      for (const auto &[i, v] : std::as_const(series_r)) {
+        f(dict_r.key_at(i), locator(i), std::as_const(v));
       }
     };
 
+    // replaces the values with vals, which go to the indices whose bits are
+    // set in present, in order. Much faster than writing them one at a time.
+    void assign(const std::vector<uint64_t> &present, std::vector<V> vals) {
+      touch();
+      series_r.assign(present, std::move(vals));
+    }
+
     // F takes (K key, locator, V value)
     template <typename F>
     void remove_if(F f) {
-      auto indices_to_delete = std::vector<index>{};
-      for (auto el : series_r) {
-        if (f(itk_r[el.first], locator(el.first), el.second)) {
-          indices_to_delete.emplace_back(el.first);
+      selection rows(map_r.index_capacity());
+      size_t num_rows = 0;
+      for (const auto &[i, v] : std::as_const(series_r)) {
+        if (f(dict_r.key_at(i), locator(i), std::as_const(v))) {
+          rows.insert(i);
+          ++num_rows;
         }
       }
 
-      for (auto ltd : indices_to_delete) {
-        erase(locator(ltd));
+      if (num_rows > 0) {
+        touch();
+        map_r.key_version = map_r.tick();
+        dict_r.erase(rows);
+        series_r.erase(rows);
       }
     };
 
     void erase(const locator &l) {
+      touch();
+      map_r.key_version = map_r.tick();
       auto i = l.loc;
-      kti_r.erase(itk_r[i]);
-      itk_r.erase(i);
+      dict_r.erase(i);
       series_r.erase(i);
     }
 
     // if the key doesn't exist, do nothing.
     void erase(const K &k) {
-      if (!has_idx_at_key(k)) {
-        return;
+      if (auto i = dict_r.find(k)) {
+        erase(locator(*i));
       }
-      auto i = kti_r[k];
-      erase(locator(i));
     }
 
     // this returns the key for a given locator in a series, or nullopt if the
@@ -221,53 +2230,92 @@ class mvmap {
       if (!has_key_at_index(l.loc)) {
         return std::nullopt;
       }
-      return itk_r[l.loc];
+      return dict_r.key_at(l.loc);
+    }
+
+    // starts or stops maintaining the series' statistics.
+    void track_stats(bool on = true) { series_r.track_stats(on); }
+
+    [[nodiscard]] series_encoding encoding() const {
+      return series_r.encoding();
+    }
+    // the dictionary and the codes of a dictionary-encoded series, or nullptr
+    // if it isn't encoded; see column_storage.
+    const key_dictionary<V> *dictionary() const {
+      return std::as_const(series_r).dictionary();
+    }
+    const column_storage<uint32_t> *codes() const {
+      return std::as_const(series_r).codes();
+    }
+
+    // the code of the value at a locator in an encoded series, or nullptr if
+    // the series has no value there or isn't encoded.
+    const uint32_t *find_code(locator l) const {
+      const auto *cs = codes();
+      if (cs == nullptr) {
+        return nullptr;
+      }
+      auto it = cs->find(l.loc);
+      return it == cs->end() ? nullptr : &(*it).second;
+    }
+
+    // the series' statistics, or nullptr if they aren't maintained. The
+    // distinct count is only brought up to date if with_distinct is set.
+    const series_stats<V> *stats(bool with_distinct = false) const {
+      return series_r.statistics(with_distinct);
     }
 
+    // the number of keys that have no value in this series.
+    [[nodiscard]] size_t null_count() const {
+      return dict_r.size() - series_r.size();
+    }
+
+    // returns the (value, key, locator) of the minimum and of the maximum
+    // value; in O(1) if the statistics are maintained, else with one scan.
     std::pair<std::optional<std::tuple<V, K, locator>>,
               std::optional<std::tuple<V, K, locator>>>
-    extrema() {
-      V min = std::numeric_limits<V>::max();
-      V max = std::numeric_limits<V>::min();
-      bool found_min = false;
-      bool found_max = false;
-      locator min_loc;
-      locator max_loc;
-      K min_key;
-      K max_key;
-      for_all([&min, &max, &found_min, &found_max, &min_loc, &max_loc, &min_key,
-               &max_key](auto k, auto l, auto v) {
-        if (v < min) {
-          min = v;
-          min_loc = l;
-          min_key = k;
-          found_min = true;
-        }
-        if (v > max) {
-          max = v;
-          max_loc = l;
-          max_key = k;
-          found_max = true;
-        }
-      });
-      std::optional<std::tuple<V, K, locator>> min_opt, max_opt;
-      if (found_min) {
-        min_opt = std::make_tuple(min, min_key, min_loc);
-      } else {
-        min_opt = std::nullopt;
-      }
-      if (found_max) {
-        max_opt = std::make_tuple(max, max_key, max_loc);
+    extrema() const {
+      std::optional<std::pair<V, index>> lo;
+      std::optional<std::pair<V, index>> hi;
+      if (const auto *st = stats()) {
+        lo = st->min();
+        hi = st->max();
       } else {
-        max_opt = std::nullopt;
+        for (const auto &[i, v] : std::as_const(series_r)) {
+          if (!lo || v < lo->first) {
+            lo = {v, i};
+          }
+          if (!hi || hi->first < v) {
+            hi = {v, i};
+          }
+        }
       }
-      return std::make_pair(min_opt, max_opt);
+      auto entry = [this](const std::optional<std::pair<V, index>> &ext)
+          -> std::optional<std::tuple<V, K, locator>> {
+        if (!ext) {
+          return std::nullopt;
+        }
+        return std::make_tuple(ext->first, dict_r.key_at(ext->second),
+                               locator(ext->second));
+      };
+      return std::make_pair(entry(lo), entry(hi));
+    }
+
+    // the number of times each value occurs, counted on num_threads threads
+    // (one per core if 0).
+    value_count_map<V> value_counts(unsigned num_threads = 0) const {
+      return ::mvmap::value_counts(std::as_const(series_r), num_threads);
+    }
+
+    // the k most frequent values and their counts, most frequent first.
+    std::vector<std::pair<V, size_t>> top_counts(
+        size_t k, unsigned num_threads = 0) const {
+      return ::mvmap::top_counts(value_counts(num_threads), k);
     }
 
-    std::map<V, size_t> count() {
-      std::map<V, size_t> ct;
-      for_all([&ct](auto /*unused*/, auto /*unused*/, auto v) { ct[v]++; });
-      return ct;
+    std::map<V, size_t> count() const {
+      auto ct = value_counts();
+      return {ct.begin(), ct.end()};
     }
 
     void print() {
@@ -284,12 +2332,10 @@ class mvmap {
         dtype = "bool";
       }
       std::cout << "dtype: " << dtype << ", ";
-      // std::cout << "kti_r.size(): " << kti_r.size() << std::endl;
-      // std::cout << "itk_r.size(): " << itk_r.size() << std::endl;
       std::cout << series_r.size() << " entries" << std::endl;
       // std::cout << "elements: " << std::endl;
-      for (auto el : series_r) {
-        std::cout << "  " << itk_r[el.first] << " -> " << el.second
+      for (const auto &el : std::as_const(series_r)) {
+        std::cout << "  " << dict_r.key_at(el.first) << " -> " << el.second
                   << std::endl;
       }
     }
@@ -297,42 +2343,341 @@ class mvmap {
   };  // end of series
   /////////////////////////////////////////////////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////////////
-  mvmap(const idx_to_key &itk, const key_to_idx &kti,
+  mvmap(key_dictionary<K> dict,
         const std::map<std::string, std::variant<series<Vs>...>> &data)
-      : itk(itk), kti(kti), data(data) {}
+      : dict(std::move(dict)), data(data) {}
 
   mvmap() = default;
+
+  // the keys and the series will allocate from mr, which must outlive the
+  // mvmap and every copy of it. A monotonic arena makes building a large
+  // table cheap: it allocates in large blocks and frees nothing until it is
+  // destroyed.
+  explicit mvmap(std::pmr::memory_resource *mr) : dict(mr), resource(mr) {}
+
+  // empties the mvmap without destroying its contents or freeing their
+  // memory, which is the fastest teardown for a process about to exit.
+  void forget() {
+    static_cast<void>(new mvmap(std::move(*this)));
+    *this = mvmap(resource);
+  }
+
   friend void tag_invoke(boost::json::value_from_tag /*unused*/,
                          boost::json::value &v, const mvmap<K, Vs...> &m) {
-    v = {{"itk", boost::json::value_from(m.itk)},
-         {"kti", boost::json::value_from(m.kti)},
-         {"data", boost::json::value_from(m.data)}};
+    std::map<std::string, std::vector<index>> index_orders;
+    for (const auto &[sel, entry] : m.indexes) {
+      auto &order = index_orders[sel];
+      if (entry.version == m.series_version(sel)) {
+        std::visit([&order](const auto &si) { order = si.sorted_order(); },
+                   entry.idx);
+      }
+    }
+    boost::json::array cache;
+    for (const auto &entry : m.selection_cache) {
+      const auto &words = entry.sel.words();
+      if (words.size() * sizeof(uint64_t) > saved_selection_bytes) {
+        continue;
+      }
+      cache.push_back({{"rule_hash", entry.rule_hash},
+                       {"rule", entry.rule},
+                       {"key_version", entry.key_version},
+                       {"deps", boost::json::value_from(entry.deps)},
+                       {"words", boost::json::value_from(words)}});
+    }
+    v = {{"itk", boost::json::value_from(m.dict)},
+         {"data", boost::json::value_from(m.data)},
+         {"indexes", boost::json::value_from(index_orders)},
+         {"clock", m.clock},
+         {"key_version", m.key_version},
+         {"versions", boost::json::value_from(m.versions)},
+         {"selection_cache", cache}};
   }
 
   friend mvmap<K, Vs...> tag_invoke(
       boost::json::value_to_tag<mvmap<K, Vs...>> /*unused*/,
       const boost::json::value &v) {
     const auto &obj = v.as_object();
-    using index = uint64_t;
-    // template <typename T> using series = std::map<index, T>;
-    using key_to_idx = std::map<K, index>;
-    using idx_to_key = std::map<index, K>;
-    return {boost::json::value_to<idx_to_key>(obj.at("itk")),
-            boost::json::value_to<key_to_idx>(obj.at("kti")),
-            boost::json::value_to<
-                std::map<std::string, std::variant<series<Vs>...>>>(
-                obj.at("data"))};
-  }
-
-  [[nodiscard]] size_t size() const { return kti.size(); }
-  bool add_key(const K &k) {
-    if (kti.count(k) > 0) {
-      return false;
+    mvmap<K, Vs...> m{
+        boost::json::value_to<key_dictionary<K>>(obj.at("itk")),
+        boost::json::value_to<
+            std::map<std::string, std::variant<series<Vs>...>>>(
+            obj.at("data"))};
+    if (const auto *clk = obj.if_contains("clock")) {
+      m.clock = boost::json::value_to<uint64_t>(*clk);
+      m.key_version = boost::json::value_to<uint64_t>(obj.at("key_version"));
+      m.versions = boost::json::value_to<std::map<std::string, uint64_t>>(
+          obj.at("versions"));
     }
-    auto i = kti.size();
-    kti[k] = i;
-    itk[i] = k;
-    return true;
+    if (const auto *cache = obj.if_contains("selection_cache")) {
+      for (const auto &el : cache->as_array()) {
+        const auto &entry = el.as_object();
+        // entries saved before the rule was kept can't be verified on a hit.
+        if (!entry.contains("rule") || !entry.contains("words")) {
+          continue;
+        }
+        m.selection_cache.push_back(
+            {boost::json::value_to<uint64_t>(entry.at("rule_hash")),
+             boost::json::value_to<std::string>(entry.at("rule")),
+             boost::json::value_to<uint64_t>(entry.at("key_version")),
+             boost::json::value_to<std::map<std::string, uint64_t>>(
+                 entry.at("deps")),
+             selection::from_words(boost::json::value_to<std::vector<uint64_t>>(
+                 entry.at("words")))});
+      }
+    }
+    if (const auto *idx = obj.if_contains("indexes")) {
+      m.restore_indexes(
+          boost::json::value_to<std::map<std::string, std::vector<index>>>(
+              *idx));
+    }
+    return m;
+  }
+
+  // The binary format, for storing and reloading large maps quickly. JSON
+  // remains the interchange format. All integers are little-endian, and
+  // every section starts at a multiple of 8 bytes:
+  //   header:  "MVMAPBIN", u32 version, u8 key kind, u8 key width, u16 0
+  //   strings: u64 n, u64 offsets[n + 1], then the bytes of every string
+  //   keys:    u64 capacity, u64 n, the bitmap of live indices, the n keys
+  //   series:  u64 n, then for each series u32 name, u32 description, u8
+  //            kind, u8 width, u8 layout, u8 indexed, u8 stats, u8
+  //            encoding, u64 n, the bitmap of indices that hold a value, and
+  //            the n values
+  // Strings are stored as ids into the string table, pairs as the array of
+  // firsts followed by the array of seconds, and bools 64 to a word. Index
+  // orders, statistics and cached selections are not stored; indexes are
+  // rebuilt on first use, and statistics when the map is loaded. Encoded
+  // series are stored decoded and re-encoded when loaded; the encoding byte
+  // was padding before, so older files read as plain.
+  static constexpr std::string_view binary_magic = "MVMAPBIN";
+  static constexpr uint32_t binary_version = 1;
+
+  void write_binary(binary::writer &w) const {
+    binary::string_table strings;
+    if constexpr (binary::has_strings<K>()) {
+      dict.for_all(
+          [&strings](const K &k, index /*unused*/) { strings.add_value(k); });
+    }
+    for (const auto &[sel, ser] : data) {
+      strings.add(sel);
+      strings.add(description(sel));
+      std::visit(
+          [&strings](const auto &col) {
+            using V = std::decay_t<decltype(col)>::mapped_type;
+            if constexpr (binary::has_strings<V>()) {
+              for (const auto &[i, v] : col) {
+                strings.add_value(v);
+              }
+            }
+          },
+          ser);
+    }
+
+    auto key_code = binary::code_of<K>();
+    w.bytes(binary_magic.data(), binary_magic.size());
+    w.scalar(binary_version);
+    w.scalar(uint8_t(key_code.kind));
+    w.scalar(key_code.width);
+    w.scalar(uint16_t{0});
+    w.strings(strings.all());
+
+    size_t num_words = (dict.capacity() + 63) / 64;
+    w.scalar(uint64_t(dict.capacity()));
+    w.scalar(uint64_t(dict.size()));
+    std::vector<uint64_t> live(dict.live_bits().begin(),
+                               dict.live_bits().end());
+    live.resize(num_words, 0);
+    w.array(live);
+    w.values<K>(strings, dict.size(), [this](auto f) {
+      dict.for_all([&f](const K &k, index /*unused*/) { f(k); });
+    });
+
+    w.scalar(uint64_t(data.size()));
+    for (const auto &[sel, ser] : data) {
+      std::visit(
+          [this, &w, &strings, &sel, num_words](const auto &col) {
+            using V = std::decay_t<decltype(col)>::mapped_type;
+            auto code = binary::code_of<V>();
+            w.scalar(strings.id(sel));
+            w.scalar(strings.id(description(sel)));
+            w.scalar(uint8_t(code.kind));
+            w.scalar(code.width);
+            w.scalar(uint8_t(col.layout()));
+            w.scalar(uint8_t(indexes.contains(sel)));
+            w.scalar(uint8_t(col.tracks_stats()));
+            w.scalar(uint8_t(col.encoding()));
+            w.align();
+
+            std::vector<uint64_t> present(num_words, 0);
+            for (const auto &[i, v] : col) {
+              present[i / 64] |= uint64_t{1} << (i % 64);
+            }
+            w.scalar(uint64_t(col.size()));
+            w.array(present);
+            w.values<V>(strings, col.size(), [&col](auto f) {
+              for (const auto &[i, v] : col) {
+                f(v);
+              }
+            });
+          },
+          ser);
+    }
+  }
+
+  void write_binary(std::ostream &os) const {
+    binary::writer w(os);
+    write_binary(w);
+    w.flush();
+  }
+
+  void save_binary(const std::string &path) const {
+    std::ofstream os(path, std::ios::binary | std::ios::trunc);
+    write_binary(os);
+    if (!os) {
+      throw std::runtime_error("cannot write " + path);
+    }
+  }
+
+  // throws std::runtime_error if the data is not a valid mvmap of this type.
+  static mvmap<K, Vs...> read_binary(binary::reader &r) {
+    if (r.bytes(binary_magic.size()) != binary_magic) {
+      throw std::runtime_error("not an mvmap binary file");
+    }
+    auto version = r.scalar<uint32_t>();
+    if (version != binary_version) {
+      throw std::runtime_error("unsupported mvmap binary version " +
+                               std::to_string(version));
+    }
+    binary::type_code key_code{char(r.scalar<uint8_t>()),
+                               r.scalar<uint8_t>()};
+    r.scalar<uint16_t>();
+    if (key_code != binary::code_of<K>()) {
+      throw std::runtime_error("mvmap binary file has a different key type");
+    }
+    auto strings = r.strings();
+    auto string_at = [&strings](uint32_t id) {
+      if (id >= strings.size()) {
+        throw std::runtime_error("corrupt string id");
+      }
+      return std::string(strings[id]);
+    };
+
+    auto capacity = r.scalar<uint64_t>();
+    auto num_keys = r.scalar<uint64_t>();
+    size_t num_words = (capacity + 63) / 64;
+    auto live = r.array<uint64_t>(num_words);
+    auto keys = r.values<K>(strings, num_keys);
+    std::vector<K> by_index(capacity);
+    size_t next = 0;
+    for (size_t w = 0; w < num_words; ++w) {
+      for (auto word = live[w]; word != 0; word &= word - 1) {
+        index i = w * 64 + std::countr_zero(word);
+        if (i >= capacity || next == keys.size()) {
+          throw std::runtime_error("corrupt mvmap keys");
+        }
+        by_index[i] = std::move(keys[next++]);
+      }
+    }
+    if (next != keys.size()) {
+      throw std::runtime_error("corrupt mvmap keys");
+    }
+
+    mvmap<K, Vs...> m;
+    m.dict = key_dictionary<K>(std::move(by_index), live);
+    m.key_version = m.tick();
+
+    auto num_series = r.scalar<uint64_t>();
+    for (uint64_t s = 0; s < num_series; ++s) {
+      auto sel = string_at(r.scalar<uint32_t>());
+      auto desc = string_at(r.scalar<uint32_t>());
+      binary::type_code code{char(r.scalar<uint8_t>()), r.scalar<uint8_t>()};
+      auto layout = r.scalar<uint8_t>();
+      bool indexed = r.scalar<uint8_t>() != 0;
+      bool stats = r.scalar<uint8_t>() != 0;
+      auto encoding = r.scalar<uint8_t>();
+      r.align();
+      auto count = r.scalar<uint64_t>();
+      auto present = r.array<uint64_t>(num_words);
+
+      if (m.has_series(sel) || layout > uint8_t(series_layout::dense) ||
+          encoding > uint8_t(series_encoding::dictionary)) {
+        throw std::runtime_error("corrupt mvmap series " + sel);
+      }
+      for (size_t w = 0; w < num_words; ++w) {
+        if ((present[w] & ~live[w]) != 0) {
+          throw std::runtime_error("corrupt mvmap series " + sel);
+        }
+      }
+      bool known = (m.template read_binary_series<Vs>(
+                        r, strings, code, sel, series_layout(layout),
+                        series_encoding(encoding), count, present) ||
+                    ...);
+      if (!known) {
+        throw std::runtime_error("series " + sel +
+                                 " has a type this mvmap can't hold");
+      }
+      m.series_desc[sel] = desc;
+      if (indexed) {
+        m.add_index(sel);
+      }
+      if (stats) {
+        m.track_series_stats(sel);
+      }
+    }
+    return m;
+  }
+
+  static mvmap<K, Vs...> read_binary(std::span<const std::byte> bytes) {
+    binary::reader r(bytes);
+    return read_binary(r);
+  }
+
+  // maps the file into memory rather than reading it through a stream.
+  static mvmap<K, Vs...> load_binary(const std::string &path) {
+    binary::mapped_file file(path);
+    return read_binary(file.bytes());
+  }
+
+  [[nodiscard]] size_t size() const { return dict.size(); }
+  bool add_key(const K &k) { return insert_key(k).second; }
+
+  // adds a key if it isn't in the map yet. Returns its index, and whether it
+  // was added.
+  std::pair<index, bool> insert_key(const K &k) {
+    auto [i, inserted] = dict.insert(k);
+    if (inserted) {
+      key_version = tick();
+    }
+    return {i, inserted};
+  }
+
+  // makes room for n more keys, so that adding them grows the dictionary at
+  // most once.
+  void reserve_keys(size_t n) { dict.reserve(dict.capacity() + n); }
+
+  // adds the keys key(0), ..., key(n - 1) that aren't in the map yet, and
+  // returns the index of each. Much faster than insert_key() one at a time
+  // on a large map; see key_dictionary::insert_batch.
+  template <typename F>
+  std::vector<index> insert_keys_by(size_t n, F key) {
+    std::vector<index> indices(n);
+    if (dict.insert_batch(n, key, indices) > 0) {
+      key_version = tick();
+    }
+    return indices;
+  }
+
+  // adds, in order, the keys of a random-access range that aren't in the
+  // map yet, and returns how many were added. The dictionary grows at most
+  // once.
+  template <std::ranges::random_access_range R>
+  size_t insert_keys(const R &keys) {
+    size_t n = std::ranges::size(keys);
+    reserve_keys(n);
+    auto first = std::ranges::begin(keys);
+    auto before = dict.size();
+    insert_keys_by(n, [first](size_t j) -> const K & { return first[j]; });
+    return dict.size() - before;
   }
 
   [[nodiscard]] std::vector<std::pair<std::string, std::string>> list_series() {
@@ -359,12 +2704,32 @@ class mvmap {
     // }
     return data.contains(id) && std::holds_alternative<series<V>>(data.at(id));
   }
-  bool contains(const K &k) { return kti.contains(k); }
-  auto keys() const { return std::views::keys(kti); }
+  bool contains(const K &k) { return dict.contains(k); }
+  auto keys() const { return dict.keys(); }
+
+  // returns the index of a key, or nullopt if it isn't in the map. Indices
+  // are below index_capacity() and stable until the map is compacted.
+  [[nodiscard]] std::optional<index> find_index(const K &k) const {
+    return dict.find(k);
+  }
+  template <std::same_as<std::string_view> L>
+    requires std::same_as<K, std::string>
+  [[nodiscard]] std::optional<index> find_index(L k) const {
+    return dict.find(k);
+  }
+  [[nodiscard]] bool has_key_at(index i) const { return dict.has_index(i); }
+  // the locator of the key at index i, and the index of a locator.
+  [[nodiscard]] static locator locator_at(index i) { return locator(i); }
+  [[nodiscard]] static index index_of(locator l) { return l.loc; }
+  // this assumes there is a key at index i.
+  [[nodiscard]] const K &key_at(index i) const { return dict.key_at(i); }
+
+  // changes whenever a key is added or removed, or the keys are renumbered,
+  // so structures built over the indices can tell when they are stale.
+  [[nodiscard]] uint64_t keys_version() const { return key_version; }
 
   void add_row(const K &key,
                const std::map<std::string, std::variant<Vs...>> &row) {
-    auto loc = locator(kti.size());
     for (const auto &el : row) {
       if (!has_series(el.first)) {
         continue;
@@ -375,7 +2740,6 @@ class mvmap {
             using variant_type = std::decay_t<decltype(ser.begin()->second)>;
             auto sproxy = get_series<std::decay_t<variant_type>>(el.first)
                               .value();  // this is a series_proxy
-            // TODO: make sure this actually sets itk and kti correctly.
             sproxy[key] = std::get<variant_type>(el.second);
           },
           data[el.first]);
@@ -383,31 +2747,35 @@ class mvmap {
   }
 
   void rem_row(const K &key) {
-    auto index = kti[key];
+    touch_all_series();
+    auto index = dict.find(key);
+    if (!index) {
+      return;
+    }
     for (auto &el : data) {
-      std::visit([&key, &index, this](auto &ser) { ser.erase(index); },
-                 el.second);
+      std::visit([&index](auto &ser) { ser.erase(*index); }, el.second);
     }
-
-    kti.erase(key);
-    itk.erase(index);
+    dict.erase(*index);
   }
   // adds a new column (series) to the mvmap and returns true. If already
   // exists, return false
   template <typename V>
-  std::optional<series_proxy<V>> add_series(const std::string &sel,
-                                            const std::string &desc = "") {
+  std::optional<series_proxy<V>> add_series(
+      const std::string &sel, const std::string &desc = "",
+      series_layout layout = series_layout::automatic) {
     if (has_series(sel)) {
       return std::nullopt;
     }
-    data[sel] = series<V>{};
+    data[sel] = series<V>{layout, resource};
     series_desc[sel] = desc;
+    versions[sel] = tick();
     return series_proxy(sel, desc, std::get<series<V>>(data[sel]), *this);
   }
 
   // copies an existing column (series) to a new (unmanifested) column and
   // returns true. If the new column already exists, or if the existing column
-  // doesn't, return false.
+  // doesn't, return false. The copy shares its storage with the original
+  // until either of them is written to.
   bool copy_series(const std::string &from, const std::string &to,
                    const std::optional<std::string> &desc = std::nullopt) {
     if (has_series(to) || !has_series(from)) {
@@ -418,6 +2786,7 @@ class mvmap {
     // std::cerr << "copying series from " << from << " to " << to << std::endl;
     data[to] = data[from];
     series_desc[to] = desc.has_value() ? desc.value() : series_desc[from];
+    versions[to] = tick();
     return true;
   }
 
@@ -449,17 +2818,99 @@ class mvmap {
     return has_series<bool>(sel);
   }
 
-  // std::optional<series_proxy<variants>> get_variant_series(
-  //     const std::string &sel) {
-  //   if (!has_series(sel)) {
-  //     return std::nullopt;
-  //   }
+  // returns a proxy to a series whose type is only known at runtime, or
+  // nullopt if the series doesn't exist.
+  std::optional<std::variant<series_proxy<Vs>...>> get_variant_series(
+      const std::string &sel) {
+    if (!has_series(sel)) {
+      return std::nullopt;
+    }
+    std::optional<std::variant<series_proxy<Vs>...>> proxy;
+    std::visit(
+        [this, &sel, &proxy](auto &coldata) {
+          using T = std::decay_t<decltype(coldata)>::mapped_type;
+          proxy.emplace(std::in_place_type<series_proxy<T>>, sel,
+                        series_desc[sel], coldata, *this);
+        },
+        data[sel]);
+    return proxy;
+  }
+
+  // changes how a series is stored and returns true. If the series doesn't
+  // exist, return false.
+  bool set_series_layout(const std::string &sel, series_layout layout) {
+    if (!has_series(sel)) {
+      return false;
+    }
+    std::visit([layout](auto &coldata) { coldata.set_layout(layout); },
+               data[sel]);
+    return true;
+  }
+
+  // dictionary-encodes a series, or decodes it, and returns true. The values
+  // don't change. If the series doesn't exist, return false.
+  bool set_series_encoding(const std::string &sel, series_encoding encoding) {
+    if (!has_series(sel)) {
+      return false;
+    }
+    std::visit([encoding](auto &coldata) { coldata.set_encoding(encoding); },
+               data[sel]);
+    return true;
+  }
+
+  // starts or stops maintaining the statistics of a series (see
+  // series_stats) and returns true. If the series doesn't exist, return
+  // false.
+  bool track_series_stats(const std::string &sel, bool on = true) {
+    if (!has_series(sel)) {
+      return false;
+    }
+    std::visit([on](auto &coldata) { coldata.track_stats(on); }, data[sel]);
+    return true;
+  }
+
+  // returns the memory a series uses, or nullopt if it doesn't exist.
+  // Storage shared with copies of the series is counted as shared.
+  [[nodiscard]] std::optional<::mvmap::memory_usage> series_memory(
+      const std::string &sel) const {
+    if (!has_series(sel)) {
+      return std::nullopt;
+    }
+    return std::visit([](const auto &coldata) { return coldata.memory(); },
+                      data.at(sel));
+  }
+
+  // returns the memory the map uses, broken down into the key dictionary and
+  // each series, with its secondary index.
+  [[nodiscard]] table_memory_usage memory_usage() const {
+    table_memory_usage usage;
+    usage.key_bytes = dict.memory_bytes();
+    for (const auto &[sel, coldata] : data) {
+      auto &ser = usage.series[sel];
+      std::visit(
+          [&ser](const auto &col) {
+            ser.dense = col.dense();
+            ser.encoding = col.encoding();
+            ser.values = col.memory();
+          },
+          coldata);
+    }
+    for (const auto &[sel, entry] : indexes) {
+      auto it = usage.series.find(sel);
+      if (it != usage.series.end()) {
+        it->second.index_bytes = std::visit(
+            [](const auto &idx) { return idx.memory_bytes(); }, entry.idx);
+      }
+    }
+    return usage;
+  }
 
-  //   using vtype = decltype(data[sel]);
-  //   return series_proxy<vtype>(sel, this->series_desc.at(sel),
-  //   data.at(sel),
-  //                              this);
-  // }
+  // returns true if a series is currently stored densely.
+  [[nodiscard]] bool series_is_dense(const std::string &sel) const {
+    return has_series(sel) &&
+           std::visit([](const auto &coldata) { return coldata.dense(); },
+                      data.at(sel));
+  }
 
   void drop_series(const std::string &sel) {
     if (!has_series(sel)) {
@@ -467,34 +2918,188 @@ class mvmap {
     }
     data.erase(sel);
     series_desc.erase(sel);
+    indexes.erase(sel);
+    versions.erase(sel);
+  }
+
+  // adds a sorted secondary index to a series and returns true. If the series
+  // doesn't exist, return false. The index is built on first use.
+  bool add_index(const std::string &sel) {
+    if (!has_series(sel)) {
+      return false;
+    }
+    if (!indexes.contains(sel)) {
+      std::visit(
+          [this, &sel](auto &coldata) {
+            using T = std::decay_t<decltype(coldata)>::mapped_type;
+            indexes[sel] = index_entry{sorted_index<T>{}, NO_VERSION};
+          },
+          data[sel]);
+    }
+    return true;
+  }
+
+  void drop_index(const std::string &sel) { indexes.erase(sel); }
+
+  [[nodiscard]] bool has_index(const std::string &sel) const {
+    return indexes.contains(sel);
+  }
+
+  // one past the largest index in use; the capacity a selection needs.
+  [[nodiscard]] size_t index_capacity() const {
+    return dict.capacity();
+  }
+
+  // returns the number of values v in an indexed series for which
+  // (v op bound) holds, or nullopt if the series isn't indexed or its values
+  // can't be compared with bound.
+  template <typename B>
+  std::optional<size_t> index_count(const std::string &sel, cmp_op op,
+                                    const B &bound) {
+    auto *entry = fresh_index(sel);
+    if (entry == nullptr) {
+      return std::nullopt;
+    }
+    return std::visit(
+        [op, &bound](const auto &si) -> std::optional<size_t> {
+          auto r = si.range(op, bound);
+          if (!r) {
+            return std::nullopt;
+          }
+          return r->second - r->first;
+        },
+        entry->idx);
+  }
+
+  // like index_count, but returns the matching locators.
+  template <typename B>
+  std::optional<selection> index_select(const std::string &sel, cmp_op op,
+                                        const B &bound) {
+    auto *entry = fresh_index(sel);
+    if (entry == nullptr) {
+      return std::nullopt;
+    }
+    return std::visit(
+        [this, op, &bound](const auto &si) -> std::optional<selection> {
+          auto r = si.range(op, bound);
+          if (!r) {
+            return std::nullopt;
+          }
+          selection result(index_capacity());
+          const auto &order = si.sorted_order();
+          for (size_t pos = r->first; pos < r->second; ++pos) {
+            result.insert(order[pos]);
+          }
+          return result;
+        },
+        entry->idx);
+  }
+
+  // returns the version of a series, or 0 if it doesn't exist.
+  [[nodiscard]] uint64_t series_version(const std::string &sel) const {
+    auto it = versions.find(sel);
+    return it == versions.end() ? 0 : it->second;
+  }
+
+  // returns a selection previously computed for a rule, provided neither the
+  // set of keys nor any of the series the rule reads have changed since. rule
+  // is the rule's canonical form and rule_hash its hash.
+  std::optional<selection> find_cached_selection(
+      uint64_t rule_hash, const std::string &rule,
+      const std::vector<std::string> &series_ids) {
+    for (auto it = selection_cache.begin(); it != selection_cache.end(); ++it) {
+      if (it->rule_hash != rule_hash || it->key_version != key_version ||
+          it->deps.size() != series_ids.size() || it->rule != rule) {
+        continue;
+      }
+      bool current = std::ranges::all_of(series_ids, [this, &it](auto &id) {
+        auto dep = it->deps.find(id);
+        return dep != it->deps.end() && dep->second == series_version(id);
+      });
+      if (!current) {
+        continue;
+      }
+      // move to the back so that the least recently used entry is evicted.
+      auto entry = std::move(*it);
+      selection_cache.erase(it);
+      selection_cache.push_back(std::move(entry));
+      return selection_cache.back().sel;
+    }
+    return std::nullopt;
+  }
+
+  void cache_selection(uint64_t rule_hash, const std::string &rule,
+                       const std::vector<std::string> &series_ids,
+                       const selection &sel) {
+    std::erase_if(selection_cache, [rule_hash, &rule](const auto &entry) {
+      return entry.rule_hash == rule_hash && entry.rule == rule;
+    });
+    if (selection_cache.size() >= selection_cache_size) {
+      selection_cache.erase(selection_cache.begin());
+    }
+    cached_selection entry{rule_hash, rule, key_version, {}, sel};
+    for (const auto &id : series_ids) {
+      entry.deps[id] = series_version(id);
+    }
+    selection_cache.push_back(std::move(entry));
+  }
+
+  // restores indexes saved by tag_invoke. An order that no longer matches its
+  // series leaves the index stale.
+  void restore_indexes(
+      const std::map<std::string, std::vector<index>> &orders) {
+    for (const auto &[sel, order] : orders) {
+      if (!has_series(sel)) {
+        continue;
+      }
+      std::visit(
+          [this, &sel, &order](auto &coldata) {
+            using T = std::decay_t<decltype(coldata)>::mapped_type;
+            auto si = sorted_index<T>::from_order(coldata, order);
+            indexes[sel] = si ? index_entry{std::move(*si), versions[sel]}
+                              : index_entry{sorted_index<T>{}, NO_VERSION};
+          },
+          data[sel]);
+    }
   }
 
   std::optional<mvmap::variants> get_as_variant(const std::string &sel,
                                                 const locator &loc) {
-    auto col = data[sel];
+    auto it = data.find(sel);
+    if (it == data.end()) {
+      return std::nullopt;
+    }
+    // reads through a reference and const access, so the series is neither
+    // copied nor detached from its copies.
+    const auto &col = it->second;
     std::optional<mvmap::variants> val;
     std::visit(
-        [&val, sel, loc, this](auto &ser) {
+        [&val, &sel, &loc, this](const auto &ser) {
           using T = std::decay_t<decltype(ser.begin()->second)>;
-          auto sproxy = get_series<std::decay_t<T>>(sel)
-                            .value();  // this is a series_proxy
-          val = sproxy.at(loc);
+          const auto sproxy = get_series<T>(sel).value();
+          if (auto v = sproxy.at(loc)) {
+            val = v->get();
+          }
         },
         col);
     return val;
-    // return data[sel][loc.loc];
   }
 
   std::optional<mvmap::variants> get_as_variant(const std::string &sel,
                                                 const K &key) {
-    auto col = data[sel];
+    auto it = data.find(sel);
+    if (it == data.end()) {
+      return std::nullopt;
+    }
+    const auto &col = it->second;
     std::optional<mvmap::variants> val;
     std::visit(
-        [&val, sel, key, this](auto &ser) {
+        [&val, &sel, &key, this](const auto &ser) {
           using T = std::decay_t<decltype(ser.begin()->second)>;
-          auto sproxy = get_series<std::decay_t<T>>(sel)
-                            .value();  // this is a series_proxy
-          val = sproxy.at(key);
+          const auto sproxy = get_series<T>(sel).value();
+          if (auto v = sproxy.at(key)) {
+            val = v->get();
+          }
         },
         col);
     return val;
@@ -504,27 +3109,53 @@ class mvmap {
   // Users will need to close over series_proxies that they want to use.
   template <typename F>
   void for_all(F f) {
-    for (auto &idx : kti) {
-      f(idx.first, locator(idx.second));
-    }
+    dict.for_all([&f](const K &k, index i) { f(k, locator(i)); });
   }
 
+  // F is a function that takes a key and a locator. If renumber is true,
+  // the remaining keys are compacted afterwards (see compact()).
   template <typename F>
-  void remove_if(F f) {
-    std::vector<index> indices_to_delete;
-    for (auto &idx : kti) {
-      if (f(idx.first, locator(idx.second))) {
-        indices_to_delete.emplace_back(idx.second);
+  void remove_if(F f, bool renumber = false) {
+    selection rows(index_capacity());
+    size_t num_rows = 0;
+    dict.for_all([&f, &rows, &num_rows](const K &k, index i) {
+      if (f(k, locator(i))) {
+        rows.insert(i);
+        ++num_rows;
       }
+    });
+
+    if (num_rows > 0) {
+      erase_rows(rows);
     }
+    if (renumber) {
+      compact();
+    }
+  }
 
-    for (auto &idx : indices_to_delete) {
-      kti.erase(itk[idx]);
-      itk.erase(idx);
-      for (auto &id_ser : data) {
-        std::visit([&idx](auto &ser) { ser.erase(idx); }, id_ser.second);
-      }
+  // removes the selected keys and their values in every series, with one
+  // pass over each series.
+  void erase_rows(const selection &rows) {
+    touch_all_series();
+    dict.erase(rows);
+    for (auto &id_ser : data) {
+      std::visit([&rows](auto &ser) { ser.erase(rows); }, id_ser.second);
+    }
+  }
+
+  // renumbers the keys densely, closing the gaps erased keys leave in every
+  // series. This invalidates all locators.
+  void compact() {
+    if (dict.size() == dict.capacity()) {
+      return;
+    }
+    auto new_index = dict.compact();
+    for (auto &id_ser : data) {
+      std::visit([&new_index](auto &ser) { ser.renumber(new_index); },
+                 id_ser.second);
     }
+    touch_all_series();
+    selection_cache.clear();
   }
 
   void print() {
@@ -547,10 +3178,12 @@ class mvmap {
     }
   }
 
-  std::string str_cols(const std::vector<std::string> &cols) {
+  // key_str converts a key to what is printed for it.
+  template <typename F = std::identity>
+  std::string str_cols(const std::vector<std::string> &cols, F key_str = {}) {
     std::stringstream sstr;
-    for_all([this, &cols, &sstr](auto key, auto loc) {
-      sstr << key << "@" << loc.loc;
+    for_all([this, &cols, &sstr, &key_str](auto key, auto loc) {
+      sstr << key_str(key) << "@" << loc.loc;
       for (auto &col : cols) {
         auto v = get_as_variant(col, loc);
         if (v.has_value()) {
@@ -598,7 +3231,7 @@ class mvmap {
           [&row, &key](auto &&arg) {
             auto v = arg.at(key);
             if (v.has_value()) {
-              row[arg.id()] = arg[key];
+              row[arg.id()] = v->get();
             }
           },
           sproxy);
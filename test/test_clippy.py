@@ -1,5 +1,6 @@
 # This should mirror test_clippy.py from the llnl-clippy repo.
 import pytest
+import struct
 import sys
 
 sys.path.append("src")
@@ -39,6 +40,14 @@ def testgraph():
     return clippy.TestGraph()
 
 
+# MetallGraph is only built with CLIPPY_WITH_METALL.
+@pytest.fixture()
+def metallgraph(tmp_path):
+    if "MetallGraph" not in clippy.__dict__:
+        pytest.skip("built without Metall")
+    return clippy.MetallGraph(str(tmp_path / "store"), "graph")
+
+
 def test_imports():
     assert "TestBag" in clippy.__dict__
 
@@ -203,3 +212,291 @@ def test_graph(testgraph):
     testgraph.degree(testgraph.node.degree)
     c_e_only = testgraph.dump2(testgraph.node.degree, where=testgraph.node.degree > 2)
     assert "c" in c_e_only and "e" in c_e_only and len(c_e_only) == 2
+
+
+def test_graph_index(testgraph):
+    testgraph.add_edge("a", "b").add_edge("b", "c").add_edge("a", "c").add_edge(
+        "c", "d"
+    ).add_edge("d", "e").add_edge("e", "f").add_edge("f", "g").add_edge("e", "g")
+
+    testgraph.add_series(testgraph.node, "degree", desc="node degrees")
+    testgraph.degree(testgraph.node.degree)
+    testgraph.add_index(testgraph.node.degree)
+    c_e_only = testgraph.dump2(testgraph.node.degree, where=testgraph.node.degree > 2)
+    assert "c" in c_e_only and "e" in c_e_only and len(c_e_only) == 2
+    c_e_only = testgraph.dump2(testgraph.node.degree, where=testgraph.node.degree == 3)
+    assert "c" in c_e_only and "e" in c_e_only and len(c_e_only) == 2
+
+
+def test_graph_index_probe(testgraph):
+    # a star, whose hub is 1 of its 9 nodes: few enough rows match for the
+    # index to be probed rather than the series scanned.
+    for leaf in "abcdefgh":
+        testgraph.add_edge("hub", leaf)
+
+    testgraph.add_series(testgraph.node, "degree", desc="node degrees")
+    testgraph.degree(testgraph.node.degree)
+    testgraph.add_index(testgraph.node.degree)
+    hub = testgraph.dump2(testgraph.node.degree, where=testgraph.node.degree > 1)
+    assert hub == ["hub"]
+    hub = testgraph.dump2(testgraph.node.degree, where=testgraph.node.degree == 8)
+    assert hub == ["hub"]
+    leaves = testgraph.dump2(testgraph.node.degree, where=testgraph.node.degree == 1)
+    assert sorted(leaves) == list("abcdefgh")
+
+    # a node without a degree leaves the index incomplete, so it is scanned.
+    testgraph.add_node("i")
+    hub = testgraph.dump2(testgraph.node.degree, where=testgraph.node.degree > 1)
+    assert hub == ["hub"]
+    hub = testgraph.dump2(testgraph.node.degree, where=testgraph.node.degree == 8)
+    assert hub == ["hub"]
+
+
+def test_graph_where_cache(testgraph):
+    testgraph.add_edge("a", "b").add_edge("b", "c").add_edge("a", "c")
+
+    testgraph.add_series(testgraph.node, "degree", desc="node degrees")
+    testgraph.degree(testgraph.node.degree)
+    first = testgraph.dump2(testgraph.node.degree, where=testgraph.node.degree > 1)
+    again = testgraph.dump2(testgraph.node.degree, where=testgraph.node.degree > 1)
+    assert sorted(first) == sorted(again) == ["a", "b", "c"]
+
+    # dump2 only reads the graph, so it doesn't save the selections it
+    # computed.
+    cache = testgraph._state["INTERNAL"]["node_table"]["selection_cache"]
+    assert cache == []
+
+    testgraph.add_edge("c", "d")
+    testgraph.drop_series(testgraph.node.degree)
+    testgraph.add_series(testgraph.node, "degree", desc="node degrees")
+    testgraph.degree(testgraph.node.degree)
+    after = testgraph.dump2(testgraph.node.degree, where=testgraph.node.degree > 1)
+    assert sorted(after) == ["a", "b", "c"]
+    leaf = testgraph.dump2(testgraph.node.degree, where=testgraph.node.degree < 2)
+    assert leaf == ["d"]
+
+
+def test_graph_summary(testgraph):
+    testgraph.add_edge("a", "b").add_edge("b", "c").add_edge("a", "c").add_edge(
+        "c", "d"
+    ).add_edge("d", "e").add_edge("e", "f").add_edge("f", "g").add_edge("e", "g")
+
+    testgraph.add_series(testgraph.node, "degree", desc="node degrees")
+    testgraph.degree(testgraph.node.degree)
+    summary = testgraph.summary(testgraph.node.degree)
+    assert summary["count"] == 7 and summary["null_count"] == 0
+    assert summary["sum"] == 16 and summary["distinct"] == 2
+    assert summary["min"][1] == 2 and summary["max"][1] == 3
+    assert summary["max"][0] in ("c", "e")
+
+    extrema = testgraph.extrema(testgraph.node.degree)
+    assert extrema["min"][1] == 2 and extrema["max"][1] == 3
+
+    testgraph.add_node("h")
+    summary = testgraph.summary(testgraph.node.degree)
+    assert summary["count"] == 7 and summary["null_count"] == 1
+
+
+def test_graph_count(testgraph):
+    testgraph.add_edge("a", "b").add_edge("b", "c").add_edge("a", "c").add_edge(
+        "c", "d"
+    ).add_edge("d", "e").add_edge("e", "f").add_edge("f", "g").add_edge("e", "g")
+
+    testgraph.add_series(testgraph.node, "degree", desc="node degrees")
+    testgraph.degree(testgraph.node.degree)
+    assert testgraph.count(testgraph.node.degree, k=1) == [[2, 5]]
+    assert testgraph.count(testgraph.node.degree, k=5) == [[2, 5], [3, 2]]
+
+
+def test_graph_set_encoding(testgraph):
+    testgraph.add_edge("a", "b").add_edge("b", "c").add_edge("a", "c").add_edge(
+        "c", "d"
+    ).add_edge("d", "e").add_edge("e", "f").add_edge("f", "g").add_edge("e", "g")
+
+    testgraph.add_series(testgraph.node, "degree", desc="node degrees")
+    testgraph.degree(testgraph.node.degree)
+    testgraph.set_encoding(testgraph.node.degree)
+    assert testgraph.count(testgraph.node.degree, k=5) == [[2, 5], [3, 2]]
+    c_e_only = testgraph.dump2(testgraph.node.degree, where=testgraph.node.degree == 3)
+    assert sorted(c_e_only) == ["c", "e"]
+
+    testgraph.set_encoding(testgraph.node.degree, encoding="plain")
+    assert testgraph.count(testgraph.node.degree, k=1) == [[2, 5]]
+
+
+def test_graph_memory_usage(testgraph):
+    testgraph.add_edge("a", "b").add_edge("b", "c").add_edge("a", "c")
+    testgraph.add_series(testgraph.node, "degree", desc="node degrees")
+    testgraph.degree(testgraph.node.degree)
+
+    usage = testgraph.memory_usage()
+    assert set(usage) == {"node_table", "edge_table"}
+    nodes = usage["node_table"]
+    assert nodes["key_bytes"] > 0
+    degree = nodes["series"]["degree"]
+    assert degree["encoding"] == "plain"
+    assert degree["total_bytes"] > 0
+    assert nodes["total_bytes"] >= nodes["key_bytes"] + degree["total_bytes"]
+
+    testgraph.set_encoding(testgraph.node.degree)
+    usage = testgraph.memory_usage()
+    assert usage["node_table"]["series"]["degree"]["encoding"] == "dictionary"
+
+
+def test_graph_connected_components(testgraph):
+    testgraph.add_edge("a", "b").add_edge("c", "b").add_edge("d", "e")
+    testgraph.add_node("f")
+
+    testgraph.add_series(testgraph.node, "cc", desc="components")
+    testgraph.connected_components(testgraph.node.cc)
+    first = testgraph.dump2(testgraph.node.cc, where=testgraph.node.cc == 0)
+    assert sorted(first) == ["a", "b", "c"]
+    second = testgraph.dump2(testgraph.node.cc, where=testgraph.node.cc == 3)
+    assert sorted(second) == ["d", "e"]
+    assert testgraph.dump2(testgraph.node.cc, where=testgraph.node.cc == 5) == ["f"]
+
+
+def test_graph_track_components(testgraph):
+    testgraph.add_edge("a", "b").track_components()
+    testgraph.add_edge("c", "d").add_edges(edges=[["d", "e"], ["b", "c"]])
+    testgraph.add_node("f")
+
+    testgraph.add_series(testgraph.node, "cc", desc="components")
+    testgraph.connected_components(testgraph.node.cc)
+    assert sorted(testgraph.dump2(testgraph.node.cc, where=testgraph.node.cc == 0)) == ["a", "b", "c", "d", "e"]
+    assert testgraph.dump2(testgraph.node.cc, where=testgraph.node.cc == 5) == ["f"]
+
+    testgraph.track_components(on=False).add_edge("f", "a")
+    testgraph.add_series(testgraph.node, "cc2", desc="components")
+    testgraph.connected_components(testgraph.node.cc2)
+    assert testgraph.dump2(testgraph.node.cc2, where=testgraph.node.cc2 != 0) == []
+
+
+def test_graph_bfs(testgraph):
+    testgraph.add_edge("a", "b").add_edge("b", "c").add_edge("c", "d")
+    testgraph.add_edge("a", "e").add_edge("d", "a")
+    testgraph.add_node("f")
+
+    testgraph.add_series(testgraph.node, "dist", desc="distance")
+    testgraph.add_series(testgraph.node, "parent", desc="parent")
+    stats = testgraph.bfs("a", testgraph.node.dist, parent=testgraph.node.parent)
+    assert stats["visited"] == 5
+    assert stats["depth"] == 3
+    assert stats["edges_traversed"] == 5
+    assert sorted(testgraph.dump2(testgraph.node.dist, where=testgraph.node.dist == 1)) == ["b", "e"]
+    assert testgraph.dump2(testgraph.node.dist, where=testgraph.node.dist == 3) == ["d"]
+    assert testgraph.dump2(testgraph.node.parent, where=testgraph.node.parent == "c") == ["d"]
+    assert testgraph.dump2(testgraph.node.dist, where=testgraph.node.dist < 0) == []
+
+    testgraph.add_series(testgraph.node, "near", desc="distance")
+    stats = testgraph.bfs("a", testgraph.node.near, max_depth=1)
+    assert stats["visited"] == 3
+    assert sorted(testgraph.dump2(testgraph.node.near, where=testgraph.node.near >= 0)) == ["a", "b", "e"]
+
+
+def test_graph_pagerank(testgraph):
+    testgraph.add_edge("a", "b").add_edge("b", "c").add_edge("c", "a")
+
+    testgraph.add_series(testgraph.node, "pr", desc="pagerank")
+    stats = testgraph.pagerank(testgraph.node.pr, tolerance=1e-10)
+    assert stats["converged"]
+    ranks = testgraph.dump2(testgraph.node.pr)
+    assert sorted(ranks) == ["a", "b", "c"]
+    assert all(abs(r - 1 / 3) < 1e-6 for r in ranks.values())
+
+    testgraph.add_edge("d", "a")
+    testgraph.add_series(testgraph.edge, "w", desc="weights")
+    testgraph.add_series(testgraph.node, "pr2", desc="pagerank")
+    testgraph.pagerank(testgraph.node.pr2, weight=testgraph.edge.w)
+    ranks = testgraph.dump2(testgraph.node.pr2)
+    assert abs(sum(ranks.values()) - 1) < 1e-6
+
+
+def test_graph_personalized_pagerank(testgraph):
+    testgraph.add_edge("a", "b").add_edge("b", "c").add_edge("d", "a")
+
+    testgraph.add_series(testgraph.node, "ppr", desc="personalized pagerank")
+    testgraph.personalized_pagerank(["a"], testgraph.node.ppr)
+    ranks = testgraph.dump2(testgraph.node.ppr)
+    assert ranks["d"] == 0
+    assert ranks["a"] > ranks["b"] > ranks["c"] > 0
+    assert abs(sum(ranks.values()) - 1) < 1e-6
+
+
+def test_graph_triangle_count(testgraph):
+    testgraph.add_edge("a", "b").add_edge("b", "c").add_edge("c", "a")
+    testgraph.add_edge("c", "d").add_edge("d", "b").add_edge("b", "d")
+    testgraph.add_edge("d", "e").add_edge("e", "e")
+
+    testgraph.add_series(testgraph.node, "tri", desc="triangles")
+    assert testgraph.triangle_count(testgraph.node.tri) == 2
+    counts = testgraph.dump2(testgraph.node.tri)
+    assert counts == {"a": 1, "b": 2, "c": 2, "d": 1, "e": 0}
+
+
+def test_graph_kcore(testgraph):
+    testgraph.add_edge("a", "b").add_edge("b", "c").add_edge("c", "a")
+    testgraph.add_edge("c", "d").add_edge("d", "b").add_edge("a", "d")
+    testgraph.add_edge("d", "e").add_edge("e", "f")
+    testgraph.add_node("g")
+
+    testgraph.add_series(testgraph.node, "core", desc="core numbers")
+    assert testgraph.kcore(testgraph.node.core) == 3
+    cores = testgraph.dump2(testgraph.node.core)
+    assert cores == {"a": 3, "b": 3, "c": 3, "d": 3, "e": 1, "f": 1, "g": 0}
+
+
+def test_graph_add_edges(testgraph, tmp_path):
+    testgraph.add_edge("a", "b")
+    testgraph.add_edges(edges=[["a", "b"], ["b", "c"], ["c", "a"], ["b", "c"]])
+    assert testgraph.nv() == 3
+    assert testgraph.ne() == 3
+
+    tsv = tmp_path / "edges.tsv"
+    tsv.write_text("# src dst\nc\td\nd  e\n\n")
+    csv = tmp_path / "edges.csv"
+    csv.write_text("e, f\nf,a\n")
+    testgraph.add_edges(path=str(tsv)).add_edges(path=str(csv))
+    assert testgraph.nv() == 6
+    assert testgraph.ne() == 7
+
+    binary = tmp_path / "edges.bin"
+    binary.write_bytes(struct.pack("<4Q", 1, 2, 2, 1))
+    testgraph.add_edges(path=str(binary))
+    assert testgraph.nv() == 8
+    assert testgraph.ne() == 9
+
+
+def test_graph_load_edge_list(testgraph, tmp_path):
+    tsv = tmp_path / "edges.tsv"
+    tsv.write_text("% src dst weight\na\tb\t0.5\nb c 2\r\nc a 4\n")
+    testgraph.add_series(testgraph.edge, "w", desc="weights")
+    stats = testgraph.load_edge_list(str(tsv), weight=testgraph.edge.w)
+    assert stats["edges"] == 3
+    assert stats["bytes"] == len(tsv.read_bytes())
+    assert stats["mb_per_s"] >= 0
+    assert testgraph.nv() == 3
+    assert sorted(testgraph.dump2(testgraph.edge.w).values()) == [0.5, 2, 4]
+
+    csv = tmp_path / "more.txt"
+    csv.write_text("c,d\n")
+    assert testgraph.load_edge_list(str(csv), format="csv")["edges"] == 1
+    assert testgraph.ne() == 4
+
+
+def test_metall_graph(metallgraph, tmp_path):
+    metallgraph.add_edge("a", "b").add_edge("b", "c").add_edge("a", "b")
+    metallgraph.add_edges(edges=[["d", "e"], ["e", "e"]]).add_node("f")
+    assert metallgraph.nv() == 6
+    assert metallgraph.ne() == 4
+
+    tsv = tmp_path / "edges.tsv"
+    tsv.write_text("c\td\n")
+    metallgraph.add_edges(path=str(tsv))
+    assert metallgraph.connected_components("cc") == 2
+    assert metallgraph.dump("cc") == {"a": 0, "b": 0, "c": 0, "d": 0, "e": 0, "f": 5}
+
+    # a second handle on the same datastore sees the same graph.
+    reopened = clippy.MetallGraph(str(tmp_path / "store"), "graph")
+    reopened.degree("deg")
+    assert reopened.dump("deg") == {"a": 1, "b": 2, "c": 2, "d": 2, "e": 2, "f": 0}